@@ -5,10 +5,13 @@
 #include <iostream>
 #include <string>
 #include <cmath>
+#include <cfloat>
+#include <algorithm>
 
 
 // X and Y dimensions are rounded to the nearest mm
 Block::Block(double xIn, double yIn, double zIn, double meshSizeIn, Material materialIn, double qGenBlockIn)
+	: material(materialIn)
 {
 	xLength = round(xIn);
 	yLength = round(yIn);
@@ -18,7 +21,14 @@ Block::Block(double xIn, double yIn, double zIn, double meshSizeIn, Material mat
 	materialName = materialIn.name;
 	qGenBlock = qGenBlockIn;
 
+	layerIndex = 0;
+	xOffset = 0;
+	yOffset = 0;
+	xElementStart = 0;
+	yElementStart = 0;
+
 	this->genMeshDimensions(meshSizeIn);
+	footprintElementCount = xElementCount * yElementCount;
 	this->calcElementProperties();
 }
 
@@ -36,6 +46,56 @@ void Block::genMeshDimensions(double meshSize) {
 	//std::cout << zElementCount << std::endl;
 }
 
+void Block::setMaterial(Material materialIn)
+{
+	material = materialIn;
+	k = materialIn.k;
+	c = materialIn.c;
+	materialName = materialIn.name;
+}
+
+void Block::setQGen(double qGenBlockIn)
+{
+	powerTrace = nullptr;
+	qGenBlock = qGenBlockIn;
+}
+
+void Block::setZLength(double zIn, double meshSize)
+{
+	zLength = zIn;
+	genMeshDimensions(meshSize);
+}
+
+void Block::updateMyElements()
+{
+	for (int i = 0; i < blockElements.size(); i++) {
+		blockElements[i]->setThermalProperties(cElement, xyRAbsolute, zRAbsolute);
+	}
+}
+
+void Block::forgetMyElements()
+{
+	blockElements.clear();
+}
+
+void Block::place(int layerIndexIn, double xOffsetIn, double yOffsetIn)
+{
+	layerIndex = layerIndexIn;
+	xOffset = xOffsetIn;
+	yOffset = yOffsetIn;
+}
+
+void Block::setElementOrigin(int xElementStartIn, int yElementStartIn)
+{
+	xElementStart = xElementStartIn;
+	yElementStart = yElementStartIn;
+}
+
+void Block::setFootprintElementCount(int footprintElementCountIn)
+{
+	footprintElementCount = footprintElementCountIn;
+}
+
 // Transforms user-input material properties for the specified mesh size
 void Block::calcElementProperties()
 {
@@ -46,22 +106,68 @@ void Block::calcElementProperties()
 
 	cElement = (c * blockVolume) / numElements;
 
-	qGenElement = qGenBlock / numElements;
+	calcHeatGenPerElement();
 
 	double xyLengthElement = xLength / xElementCount; // square XY
 	double zLengthElement = zLength / zElementCount;
 	double sideAreaElement = xyLengthElement * zLengthElement;
 	double verticalAreaElement = xyLengthElement * xyLengthElement;
+	faceAreaElement = verticalAreaElement;
+	this->sideAreaElement = sideAreaElement;
 
 	xyRAbsolute = (xyLengthElement / 2) / (k * sideAreaElement);
 	zRAbsolute = (zLengthElement / 2) / (k * verticalAreaElement);
 }
 
+void Block::calcHeatGenPerElement()
+{
+	int heatedElements = footprintElementCount * zElementCount;
+	qGenElement = (heatedElements > 0) ? qGenBlock / heatedElements : 0;
+}
+
 void Block::rememberMyElement(MeshElement * elementPtr)
 {
 	blockElements.push_back(elementPtr);
 }
 
+// Elements already meshed start generating the trace's initial power at once
+void Block::setPowerTrace(std::shared_ptr<PowerTrace> powerTraceIn)
+{
+	powerTrace = powerTraceIn;
+	qGenBlock = powerTrace->getPower(0);
+	calcHeatGenPerElement();
+}
+
+bool Block::hasPowerTrace()
+{
+	return (powerTrace != nullptr);
+}
+
+double Block::getPowerTraceEndTime()
+{
+	return powerTrace->getEndTime();
+}
+
+std::string Block::getPowerTracePath()
+{
+	return powerTrace->getPath();
+}
+
+// Restarts the trace from its beginning and resets this block's power to match
+void Block::rewindPowerTrace()
+{
+	powerTrace->rewind();
+	qGenBlock = powerTrace->getPower(0);
+	calcHeatGenPerElement();
+}
+
+// Called every time step for traced blocks, so it only rescales the per-element share of the block's power
+void Block::updatePowerFromTrace(double time)
+{
+	qGenBlock = powerTrace->getPower(time);
+	calcHeatGenPerElement();
+}
+
 // Calculates mean temperature of this block
 double Block::getBulkTemp()
 {
@@ -116,16 +222,65 @@ double Block::getTempNonUniformity()
 	return (high - low);
 }
 
+// Sum of element temperatures, zero if this block holds no elements
+double Block::getTempSum()
+{
+	double temperatureSum = 0;
+
+	for (int i = 0; i < blockElements.size(); i++) {
+		temperatureSum += blockElements[i]->getTemperature();
+	}
+
+	return temperatureSum;
+}
+
+// Coldest element temperature, DBL_MAX if this block holds no elements
+double Block::getTempMin()
+{
+	double low = DBL_MAX;
+
+	for (int i = 0; i < blockElements.size(); i++) {
+		low = std::min(low, blockElements[i]->getTemperature());
+	}
+
+	return low;
+}
+
+// Hottest element temperature, -DBL_MAX if this block holds no elements
+double Block::getTempMax()
+{
+	double high = -DBL_MAX;
+
+	for (int i = 0; i < blockElements.size(); i++) {
+		high = std::max(high, blockElements[i]->getTemperature());
+	}
+
+	return high;
+}
+
 // Accessors
 std::string Block::getMaterialName() { return materialName; }
+double Block::getK() { return k; }
+double Block::getKAt(double temperature) { return material.getK(temperature); }
+bool Block::isTemperatureDependent() { return material.isTemperatureDependent(); }
+Material Block::getMaterial() { return material; }
+double Block::getC() { return c; }
 double Block::getQGen() { return qGenBlock; }
 double Block::getQGenElement() { return qGenElement; }
 double Block::getCElement() { return cElement; }
 double Block::getXYRAbsolute() { return xyRAbsolute; }
 double Block::getZRAbsolute() { return zRAbsolute; }
-double Block::getXLength() { return yLength; }
+double Block::getElementFaceArea() { return faceAreaElement; }
+double Block::getElementSideArea() { return sideAreaElement; }
+double Block::getXLength() { return xLength; }
 double Block::getYLength() { return yLength; }
+double Block::getZLength() { return zLength; }
 double Block::getVolume() { return (xLength * yLength * zLength); }
+double Block::getXOffset() { return xOffset; }
+double Block::getYOffset() { return yOffset; }
+int Block::getLayerIndex() { return layerIndex; }
+int Block::getXElementStart() { return xElementStart; }
+int Block::getYElementStart() { return yElementStart; }
 int Block::getXElementCount() { return xElementCount; }
 int Block::getYElementCount() { return yElementCount; }
 int Block::getZElementCount() { return zElementCount; }
@@ -3,7 +3,9 @@
 
 #pragma once
 #include <vector>
+#include <memory>
 #include "Material.h"
+#include "PowerTrace.h"
 #include "MeshElement.h"
 class MeshElement;
 
@@ -18,25 +20,75 @@ public:
 
 	void genMeshDimensions(double meshSize);
 
+	// Edits, followed by calcElementProperties() where needed. setQGen() drops any power trace
+	void setMaterial(Material materialIn);
+	void setQGen(double qGenBlockIn);
+	void setZLength(double zIn, double meshSize);
+
+	// Pushes this block's current element heat capacity and resistances down to its elements, after an edit
+	// Heat gen is not pushed; elements read it from getQGenElement() through the stack every step
+	void updateMyElements();
+
+	// Drops the element list ahead of a re-mesh
+	void forgetMyElements();
+
+	// Positions the block within the stack: its layer, and the offset of its centre from the stack centreline [mm]
+	void place(int layerIndexIn, double xOffsetIn, double yOffsetIn);
+
+	// Lower corner of the block's footprint in the element grid, assigned when the stack is meshed
+	void setElementOrigin(int xElementStartIn, int yElementStartIn);
+
+	// Elements per z-layer the block actually holds, fewer than its full footprint where a block added earlier to
+	// its layer overlaps it. Heat gen is spread over these, so the block's power is kept whole
+	void setFootprintElementCount(int footprintElementCountIn);
+
 	void calcElementProperties();
 
 	void rememberMyElement(MeshElement * elementPtr);
 
+	// Drives this block's heat generation from a power-versus-time trace instead of a constant
+	void setPowerTrace(std::shared_ptr<PowerTrace> powerTraceIn);
+	bool hasPowerTrace();
+	void rewindPowerTrace();
+	double getPowerTraceEndTime();
+	std::string getPowerTracePath();
+
+	// Samples the trace at the given time and updates the block's heat gen, without touching its elements
+	void updatePowerFromTrace(double time);
+
 	double getBulkTemp();
 
 	double getTempStandardDeviation();
 
 	double getTempNonUniformity();
 
+	// Partial statistics over the elements this block holds, for combining across processes
+	double getTempSum();
+	double getTempMin();
+	double getTempMax();
+
 	std::string getMaterialName();
+	double getK();
+	double getKAt(double temperature);
+	bool isTemperatureDependent();
+	Material getMaterial();
+	double getC();
 	double getQGen();
 	double getQGenElement();
 	double getCElement();
 	double getXYRAbsolute();
 	double getZRAbsolute();
+	double getElementFaceArea();
+	double getElementSideArea();
 	double getXLength();
 	double getYLength();
+	double getZLength();
 	double getVolume();
+	double getXOffset();
+	double getYOffset();
+	int getLayerIndex();
+	int getXElementStart();
+	int getYElementStart();
 	int getXElementCount();
 	int getYElementCount();
 	int getZElementCount();
@@ -44,6 +96,10 @@ public:
 
 private:
 
+	// Spreads the block's power over the elements it holds
+	void calcHeatGenPerElement();
+
+	Material material;
 	std::string materialName;
 
 	double xLength; 	// rounded length [mm]
@@ -56,6 +112,9 @@ private:
 	double xyRAbsolute; // element absolute half resistance [K/W]
 	double zRAbsolute;
 
+	double faceAreaElement; // element XY face area [mm^2]
+	double sideAreaElement; // element XZ/YZ face area [mm^2]
+
 	double c;			// material volumetric heat capacity [J/mm^3K]
 	double cElement; 	// per-element heat capacity [J/K]
 
@@ -66,7 +125,16 @@ private:
 	int yElementCount;
 	int zElementCount;
 
+	int layerIndex;		// placement within the stack
+	double xOffset;		// block centre relative to the stack centreline [mm]
+	double yOffset;
+	int xElementStart;	// footprint origin in the element grid
+	int yElementStart;
+	int footprintElementCount;	// elements per z-layer left after overlaps are resolved
+
 	std::vector<MeshElement *> blockElements;
 
+	std::shared_ptr<PowerTrace> powerTrace;	// null for constant power
+
 };
 
@@ -0,0 +1,29 @@
+// Splits a ThermalStack across several processes, each owning a contiguous range of z-layers.
+// ThermalStack only talks to this interface; MPIDecomposition provides the MPI implementation.
+//
+// Each rank meshes and steps only its own layers plus a one-layer halo on either side. After every time step the
+// boundary layers are swapped with the neighbouring ranks, and block statistics and convergence are reduced globally.
+
+#pragma once
+
+class DomainDecomposition
+{
+
+public:
+
+	virtual ~DomainDecomposition() {}
+
+	virtual int getRank() = 0;
+	virtual int getRankCount() = 0;
+
+	// Sends this rank's lowest and highest owned layers to the ranks below and above,
+	// and receives their boundary layers into this rank's halos. Edge ranks skip the missing side.
+	virtual void exchangeHalo(double * sendLower, double * receiveLower,
+							  double * sendUpper, double * receiveUpper,
+							  int count) = 0;
+
+	// In-place global reductions across all ranks
+	virtual void sum(double * values, int count) = 0;
+	virtual void min(double * values, int count) = 0;
+	virtual void max(double * values, int count) = 0;
+};
@@ -0,0 +1,64 @@
+// MPI implementation of DomainDecomposition over MPI_COMM_WORLD.
+// Only compiled when THERMALSTACK_MPI is defined.
+
+#include "MPIDecomposition.h"
+#ifdef THERMALSTACK_MPI
+#include <mpi.h>
+
+MPIDecomposition::MPIDecomposition()
+{
+	int initialized = 0;
+	MPI_Initialized(&initialized);
+
+	ownsMPI = (initialized == 0);
+	if (ownsMPI) {
+		MPI_Init(nullptr, nullptr);
+	}
+
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &rankCount);
+}
+
+MPIDecomposition::~MPIDecomposition()
+{
+	if (ownsMPI) {
+		MPI_Finalize();
+	}
+}
+
+int MPIDecomposition::getRank() { return rank; }
+int MPIDecomposition::getRankCount() { return rankCount; }
+
+// Two paired Sendrecvs, one moving data upward through the ranks and one downward
+void MPIDecomposition::exchangeHalo(double * sendLower, double * receiveLower,
+									double * sendUpper, double * receiveUpper,
+									int count)
+{
+	int lowerRank = (rank > 0) ? rank - 1 : MPI_PROC_NULL;
+	int upperRank = (rank < rankCount - 1) ? rank + 1 : MPI_PROC_NULL;
+
+	MPI_Sendrecv(sendUpper, count, MPI_DOUBLE, upperRank, 0,
+				 receiveLower, count, MPI_DOUBLE, lowerRank, 0,
+				 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+	MPI_Sendrecv(sendLower, count, MPI_DOUBLE, lowerRank, 1,
+				 receiveUpper, count, MPI_DOUBLE, upperRank, 1,
+				 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+}
+
+void MPIDecomposition::sum(double * values, int count)
+{
+	MPI_Allreduce(MPI_IN_PLACE, values, count, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+}
+
+void MPIDecomposition::min(double * values, int count)
+{
+	MPI_Allreduce(MPI_IN_PLACE, values, count, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+}
+
+void MPIDecomposition::max(double * values, int count)
+{
+	MPI_Allreduce(MPI_IN_PLACE, values, count, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+}
+
+#endif
@@ -0,0 +1,46 @@
+// MPI implementation of DomainDecomposition over MPI_COMM_WORLD.
+// Only compiled when THERMALSTACK_MPI is defined, e.g. mpicxx -DTHERMALSTACK_MPI ...
+//
+// Example Usage:
+//
+//		MPIDecomposition decomposition;
+//		myThermalCircuit.decompose(&decomposition);	// before mesh()
+//		myThermalCircuit.mesh();
+//		myThermalCircuit.solve();
+//
+//		mpirun -np 4 ./ThermalStackFEA
+
+#pragma once
+#ifdef THERMALSTACK_MPI
+#include "DomainDecomposition.h"
+
+class MPIDecomposition : public DomainDecomposition
+{
+
+public:
+
+	// Initializes MPI unless the caller already has
+	MPIDecomposition();
+
+	// Finalizes MPI only if this object initialized it
+	~MPIDecomposition();
+
+	int getRank();
+	int getRankCount();
+
+	void exchangeHalo(double * sendLower, double * receiveLower,
+					  double * sendUpper, double * receiveUpper,
+					  int count);
+
+	void sum(double * values, int count);
+	void min(double * values, int count);
+	void max(double * values, int count);
+
+private:
+
+	bool ownsMPI;
+	int rank;
+	int rankCount;
+};
+
+#endif
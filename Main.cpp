@@ -13,6 +13,7 @@
 
 #include "ThermalStack.h"
 #include "Material.h"
+#include "MPIDecomposition.h"
 #include <string>
 #include <iostream>
 
@@ -20,6 +21,11 @@ using namespace std;
 
 int main() {
 
+#ifdef THERMALSTACK_MPI
+	// split the model across processes, e.g. mpirun -np 4 ./ThermalStackFEA
+	MPIDecomposition decomposition;
+#endif
+
 	// define mesh and solver parameters here
 	const double meshSize = 0.5;						// mm
 	const double timeStep = 0.0001;						// sec
@@ -33,11 +39,14 @@ int main() {
 	Material aluminum(0.205, 0.002424,	"Aluminum");
 	Material copper(0.401, 0.003450,	"Copper  ");
 	Material tim(0.01, 0.003476,		"TIM Pad ");
-	Material water(0.01, 20000,			"Water   ");
-	//				 ^	   ^				note about water parameters:
-	// artificial k to achieve desired convective heat transfer coefficient (see excel sheet)
-	// artificial c to behave as infinite heat sink
-	// c value must be <32767 roughly to avoid fucking with some int variable somewhere
+
+	// conductivity may instead be tabulated against temperature, inputs are ({T [C]}, {k [W/mmK]}, heat capacity, name)
+	// Material silicon({ 25, 75, 125, 175 }, { 0.148, 0.119, 0.098, 0.083 }, 0.001643, "Silicon ");
+
+	// define convective boundary conditions here
+	// inputs are (heat transfer coefficient h [W/mm^2K], ambient fluid temperature [C])
+	const double hWater = 0.04;							// W/mm^2K, i.e. 40000 W/m^2K
+	const double waterTemperature = 65;					// degrees C
 
 	ThermalStack semiconductorSandwich(meshSize, 
 									   timeStep, 
@@ -48,27 +57,47 @@ int main() {
 	// Define your physical system here
 	// Blocks are stacked in order of initialization
 	// Inputs are (xLength [mm], yLength [mm], zDepth [mm], material object, heat gen [W])
+	// Thin layers (TIMs, solder, bond lines) can be added as unmeshed interfaces between two blocks
+	// Interface inputs are (material object, thickness [mm]) or (area-specific resistance [K*mm^2/W])
 
-	semiconductorSandwich.addBlock(15, 15, meshSize, water, 0);	// block 0		---------------
-	semiconductorSandwich.addBlock(15, 15, 3, aluminum, 0);		// block 1		---------------
-	semiconductorSandwich.addBlock(10, 10, 0.5, tim, 0);		// block 2		   ---------
+	semiconductorSandwich.addBlock(15, 15, 3, aluminum, 0);		// block 0		---------------
+	semiconductorSandwich.addInterface(tim, 0.5);				//				   ~~~~~~~~~
+	semiconductorSandwich.addBlock(10, 10, 2, copper, 0);		// block 1		   ---------
+	semiconductorSandwich.addBlock(5, 5, 1, silicon, 100);		// block 2			 -----
 	semiconductorSandwich.addBlock(10, 10, 2, copper, 0);		// block 3		   ---------
-	semiconductorSandwich.addBlock(5, 5, 1, silicon, 100);		// block 4			 -----
-	semiconductorSandwich.addBlock(10, 10, 2, copper, 0);		// block 5		   ---------			
-	semiconductorSandwich.addBlock(10, 10, 0.5, tim, 0);		// block 6		   ---------
-	semiconductorSandwich.addBlock(15, 15, 3, aluminum, 0);		// block 7		---------------
-	semiconductorSandwich.addBlock(15, 15, meshSize, water, 0);	// block 8		---------------
+	semiconductorSandwich.addInterface(tim, 0.5);				//				   ~~~~~~~~~
+	semiconductorSandwich.addBlock(15, 15, 3, aluminum, 0);		// block 4		---------------
+
+	// Water-cooled on both outer faces of the stack
+	semiconductorSandwich.setConvectionBottom(hWater, waterTemperature);
+	semiconductorSandwich.setConvectionTop(hWater, waterTemperature);
+
+#ifdef THERMALSTACK_MPI
+	semiconductorSandwich.decompose(&decomposition);
+#endif
 
 	// Generates a 3D model in which material masses are divided into discrete, cubic/rectangular elements
 	// Prepares a linear datastructure of element associations for calculating heat transfer physics
 	semiconductorSandwich.mesh();
 
 	// Specify block for convergence monitoring -- block must be a heat source
-	semiconductorSandwich.monitorBlock(4);
+	semiconductorSandwich.monitorBlock(2);
+
+	// Optionally, find the coarsest mesh size that keeps the impedance and block temperatures within 1%
+	// semiconductorSandwich.studyMeshConvergence({ 2, 1, 0.5 }, 0.01);
 
 	// March the solution and output data realtime and post-convergence
 	semiconductorSandwich.solve();
 
+	// Alternatively, solve for the steady state directly, or find which layers dominate the impedance
+	// semiconductorSandwich.solveSteady();
+	// semiconductorSandwich.computeSensitivities();
+	// semiconductorSandwich.computeTimeConstants();
+
+	// Edit a block and solve again, starting from the current temperatures
+	// semiconductorSandwich.setBlockMaterial(1, aluminum);
+	// semiconductorSandwich.solve();
+
 	// Pause
 	string input;
 	cin >> input;
@@ -1,12 +1,68 @@
 #pragma once
 #include <string>
+#include <vector>
+#include <cmath>
 
 struct Material {
-	
+
 	Material(double kIn, double cIn, std::string nameIn) {
 		c = cIn;
 		k = kIn;
 		name = nameIn;
+		lookupStart = 0;
+		lookupStep = 0;
+	}
+
+	// Temperature-dependent conductivity, tabulated as k [W/mmK] at increasing temperatures [C].
+	// Linear between points and flat outside them. k is the value at the first point.
+	// The table is resampled once onto a fine uniform grid so that lookups are a single index.
+	Material(std::vector<double> kTemperaturesIn, std::vector<double> kValuesIn, double cIn, std::string nameIn) {
+		c = cIn;
+		name = nameIn;
+		kTemperatures = kTemperaturesIn;
+		kValues = kValuesIn;
+		k = kValues.empty() ? 0 : kValues[0];
+		lookupStart = 0;
+		lookupStep = 0;
+
+		if (kTemperatures.size() < 2 || kTemperatures.size() != kValues.size() || kTemperatures.back() <= kTemperatures.front()) {
+			return;
+		}
+
+		const int lookupIntervals = 1024;
+		lookupStart = kTemperatures.front();
+		lookupStep = (kTemperatures.back() - lookupStart) / lookupIntervals;
+
+		unsigned int segment = 0;
+		for (int i = 0; i <= lookupIntervals; i++) {
+			double temperature = lookupStart + i * lookupStep;
+			while (segment + 2 < kTemperatures.size() && temperature > kTemperatures[segment + 1]) {
+				segment++;
+			}
+			double fraction = (temperature - kTemperatures[segment]) / (kTemperatures[segment + 1] - kTemperatures[segment]);
+			fraction = std::fmin(std::fmax(fraction, 0.0), 1.0);
+			kLookup.push_back(kValues[segment] + fraction * (kValues[segment + 1] - kValues[segment]));
+		}
+	}
+
+	bool isTemperatureDependent() const {
+		return !kLookup.empty();
+	}
+
+	// thermal conductivity at the given temperature, [W/mmK]
+	double getK(double temperature) const {
+		if (kLookup.empty()) {
+			return k;
+		}
+
+		double position = (temperature - lookupStart) / lookupStep;
+		if (!(position > 0)) {
+			return kLookup.front();
+		}
+		if (position >= kLookup.size() - 1) {
+			return kLookup.back();
+		}
+		return kLookup[(int)(position + 0.5)];
 	}
 
 	// volumetric heat capacity, [J/mm^3K]
@@ -17,6 +73,13 @@ struct Material {
 
 	std::string name;
 
-};
+	// k(T) table as given, empty for constant k
+	std::vector<double> kTemperatures;
+	std::vector<double> kValues;
 
+private:
 
+	std::vector<double> kLookup;
+	double lookupStart;
+	double lookupStep;
+};
@@ -0,0 +1,58 @@
+// Contains and executes element-ambient relationships
+// In the case of thermal FEA, convective heat transfer from an exposed element face to a fluid at fixed temperature
+
+#include "MeshBoundary.h"
+
+MeshBoundary::MeshBoundary(MeshElement * elementIn,
+						   double halfResistanceIn,
+						   double hIn,
+						   double faceAreaIn,
+						   double ambientTemperatureIn,
+						   bool sideFaceIn)
+{
+	element = elementIn;
+	halfResistance = halfResistanceIn;
+	h = hIn;
+	faceArea = faceAreaIn;
+	ambientTemperature = ambientTemperatureIn;
+	sideFace = sideFaceIn;
+
+	resistanceAbsolute = halfResistance + getFilmResistance();
+}
+
+MeshBoundary::~MeshBoundary()
+{
+}
+
+// Updates the conduction half resistance and exposed area after the element's block has been edited
+void MeshBoundary::setGeometry(double halfResistanceIn, double faceAreaIn)
+{
+	halfResistance = halfResistanceIn;
+	faceArea = faceAreaIn;
+
+	resistanceAbsolute = halfResistance + getFilmResistance();
+}
+
+void MeshBoundary::calcResistance()
+{
+	halfResistance = sideFace ? element->getXYRAbsolute() : element->getZRAbsolute();
+
+	resistanceAbsolute = halfResistance + getFilmResistance();
+}
+
+// Accessors
+MeshElement * MeshBoundary::getElement() { return element; }
+bool MeshBoundary::isSideFace() { return sideFace; }
+double MeshBoundary::getHalfResistance() { return halfResistance; }
+double MeshBoundary::getFilmResistance() { return 1 / (h * faceArea); }
+double MeshBoundary::getAmbientTemperature() { return ambientTemperature; }
+double MeshBoundary::getResistanceAbsolute() { return resistanceAbsolute; }
+
+void MeshBoundary::calcEnergyTransfer(double timeStep)
+{
+	double dT = element->getTemperature() - ambientTemperature;
+	double q = dT / resistanceAbsolute;
+	double energy = q * timeStep;
+
+	element->setPendingEnergy(-energy);
+}
@@ -0,0 +1,44 @@
+// Contains and executes element-ambient relationships
+// In the case of thermal FEA, convective heat transfer from an exposed element face to a fluid at fixed temperature
+
+#pragma once
+#include "MeshElement.h"
+
+class MeshBoundary
+{
+
+public:
+	MeshBoundary(MeshElement * elementIn,
+				 double halfResistanceIn,
+				 double hIn,
+				 double faceAreaIn,
+				 double ambientTemperatureIn,
+				 bool sideFaceIn);
+	~MeshBoundary();
+	void calcEnergyTransfer(double timeStep);
+	void setGeometry(double halfResistanceIn, double faceAreaIn);
+
+	// Picks up the element's current half resistance, after a conductivity change
+	void calcResistance();
+
+	MeshElement * getElement();
+	bool isSideFace();
+	double getHalfResistance();
+	double getFilmResistance();
+	double getAmbientTemperature();
+	double getResistanceAbsolute();
+
+private:
+
+	MeshElement * element;
+
+	double h;					// heat transfer coefficient [W/mm^2K]
+	double faceArea;			// exposed face area [mm^2]
+	double ambientTemperature;	// fluid temperature [C]
+	bool sideFace;				// X/Y face, as opposed to top/bottom
+
+	double halfResistance;		// element center to face [K/W]
+
+	// element center to fluid thermal impedance, conduction half-element plus film [K/W]
+	double resistanceAbsolute;
+};
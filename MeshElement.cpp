@@ -4,27 +4,28 @@
 #include "MeshElement.h"
 #include <iostream>
 #include <algorithm>
+#include <limits>
 
 // While an incompletely defined element should be considered "inactive" until fully defined, setting the element to not-empty
 // by default is necessary to be able to access the element with ThermalStack::nav3DArray later on
 MeshElement::MeshElement() { empty = false; };
 
 MeshElement::MeshElement(double temperatureIn,
-						 double energyGenPerTimestepIn,
 						 double cElementIn,
 						 double xyRAbsoluteIn,
 						 double zRAbsoluteIn,
-						 int zLayerIn)
+						 int zLayerIn,
+						 int blockIndexIn)
 {
 	empty = false;
 	energyExternalPending = 0;
 
 	temperature = temperatureIn;
-	energyGenPerTimestep = energyGenPerTimestepIn;
 	cElement = cElementIn;
 	xyRAbsolute = xyRAbsoluteIn;
 	zRAbsolute = zRAbsoluteIn;
 	zLayer = zLayerIn;
+	blockIndex = blockIndexIn;
 }
 
 MeshElement::~MeshElement()
@@ -36,9 +37,11 @@ bool MeshElement::isEmpty()
 	return empty; // bool
 }
 
+// empty positions read as NaN through ThermalStack::getTemperatureField()
 void MeshElement::makeEmpty()
 {
 	empty = true;
+	temperature = std::numeric_limits<double>::quiet_NaN();
 }
 
 void MeshElement::rememberNeighbor(MeshElement * potentialNeighbor)
@@ -58,6 +61,10 @@ int MeshElement::getZLayer()
 {
 	return zLayer;
 }
+int MeshElement::getBlockIndex()
+{
+	return blockIndex;
+}
 double MeshElement::getXYRAbsolute()
 {
 	return xyRAbsolute;
@@ -66,10 +73,32 @@ double MeshElement::getZRAbsolute()
 {
 	return zRAbsolute;
 }
+double MeshElement::getCElement()
+{
+	return cElement;
+}
 double MeshElement::getTemperature()
 {
 	return temperature;
 }
+const double * MeshElement::getTemperatureAddress()
+{
+	return &temperature;
+}
+
+// overwrites this element's temperature, used to fill halo elements owned by another process
+void MeshElement::setTemperature(double temperatureIn)
+{
+	temperature = temperatureIn;
+}
+
+// replaces this element's heat capacity and half resistances after its block has been edited
+void MeshElement::setThermalProperties(double cElementIn, double xyRAbsoluteIn, double zRAbsoluteIn)
+{
+	cElement = cElementIn;
+	xyRAbsolute = xyRAbsoluteIn;
+	zRAbsolute = zRAbsoluteIn;
+}
 
 // lines up a calculated energy transfer value for the next time step
 void MeshElement::setPendingEnergy(double energyTransfer)
@@ -79,16 +108,16 @@ void MeshElement::setPendingEnergy(double energyTransfer)
 }
 
 // modifies this elements temperature/interal energy with the queued energy transfer value
-void MeshElement::applyEnergyTransfer()
+void MeshElement::applyEnergyTransfer(const double * blockEnergyGenPerTimestep)
 {
 	if (this->empty) {
 		return;
 	}
 
 	// sum internal and external energy components
-	double energySum = energyGenPerTimestep + energyExternalPending;
+	double energySum = blockEnergyGenPerTimestep[blockIndex] + energyExternalPending;
 
-	//std::cout << "energyGenPerTimestep" << energyGenPerTimestep << std::endl;
+	//std::cout << "energyGenPerTimestep" << blockEnergyGenPerTimestep[blockIndex] << std::endl;
 	//std::cout << "energyExternalPending" << energyExternalPending << std::endl;
 	//std::cout << std::endl;
 
@@ -99,3 +128,9 @@ void MeshElement::applyEnergyTransfer()
 	temperature += dT;
 	energyExternalPending = 0;
 }
+
+// heap and inline memory held by this element, for instrumentation
+size_t MeshElement::getFootprintBytes()
+{
+	return sizeof(MeshElement) + neighbors.capacity() * sizeof(MeshElement *);
+}
@@ -3,6 +3,7 @@
 
 #pragma once
 #include <vector>
+#include <cstddef>
 
 class MeshElement
 {
@@ -10,22 +11,29 @@ public:
 	
 	MeshElement();
 	MeshElement(double temperatureIn,
-				double energyGenPerTimestepIn,
 				double cElementIn,
 				double xyRAbsoluteIn,
 				double zRAbsoluteIn,
-				int zLayerIn);
+				int zLayerIn,
+				int blockIndexIn);
 	~MeshElement();
 	bool isEmpty();
 	void makeEmpty();
 	void rememberNeighbor(MeshElement * potentialNeighbor);
 	bool checkForExistingNode(MeshElement * potentialNeighbor);
 	int getZLayer();
+	int getBlockIndex();
 	double getXYRAbsolute();
 	double getZRAbsolute();
+	double getCElement();
 	double getTemperature();
+	const double * getTemperatureAddress();
+	void setTemperature(double temperatureIn);
+	void setThermalProperties(double cElementIn, double xyRAbsoluteIn, double zRAbsoluteIn);
 	void setPendingEnergy(double energyTransfer);
-	void applyEnergyTransfer();
+	// Heat gen is per block, indexed by this element's block, so a block's power changes without touching its elements
+	void applyEnergyTransfer(const double * blockEnergyGenPerTimestep);
+	size_t getFootprintBytes();
 
 private:
 
@@ -34,11 +42,11 @@ private:
 	std::vector<MeshElement *> neighbors;
 
 	double temperature;
-	double energyGenPerTimestep;
 	double cElement;				// J/K
 	double xyRAbsolute;
 	double zRAbsolute;
 	int zLayer;
+	int blockIndex;					// owning block in ThermalStack
 	double energyExternalPending;
 };
 
@@ -4,19 +4,26 @@
 #include "MeshNode.h"
 #include <iostream>
 
-MeshNode::MeshNode(MeshElement * firstIn, MeshElement * secondIn)
+MeshNode::MeshNode(MeshElement * firstIn, MeshElement * secondIn, double interfaceResistanceIn)
 {
 	first = firstIn;
 	second = secondIn;
+	interfaceResistance = interfaceResistanceIn;
 
 	first->rememberNeighbor(second);
 	second->rememberNeighbor(first);
 
-	if (first->getZLayer() == second->getZLayer()) {
+	calcResistance();
+}
+
+// Sums the two element half resistances, plus any interface, along this link's direction
+void MeshNode::calcResistance()
+{
+	if (!isZLink()) {
 		resistanceAbsolute = first->getXYRAbsolute() + second->getXYRAbsolute();
 	}
 	else {
-		resistanceAbsolute = first->getZRAbsolute() + second->getZRAbsolute();
+		resistanceAbsolute = first->getZRAbsolute() + second->getZRAbsolute() + interfaceResistance;
 	}
 }
 
@@ -24,6 +31,13 @@ MeshNode::~MeshNode()
 {
 }
 
+// Accessors
+MeshElement * MeshNode::getFirst() { return first; }
+MeshElement * MeshNode::getSecond() { return second; }
+bool MeshNode::isZLink() { return (first->getZLayer() != second->getZLayer()); }
+double MeshNode::getInterfaceResistance() { return interfaceResistance; }
+double MeshNode::getResistanceAbsolute() { return resistanceAbsolute; }
+
 void MeshNode::calcEnergyTransfer(double timeStep)
 {
 	double dT = first->getTemperature() - second->getTemperature();
@@ -8,15 +8,25 @@ class MeshNode
 {
 
 public:
-	MeshNode(MeshElement * firstIn, MeshElement * secondIn);
+	MeshNode(MeshElement * firstIn, MeshElement * secondIn, double interfaceResistanceIn);
 	~MeshNode();
 	void calcEnergyTransfer(double timeStep);
+	void calcResistance();
+
+	MeshElement * getFirst();
+	MeshElement * getSecond();
+	bool isZLink();
+	double getInterfaceResistance();
+	double getResistanceAbsolute();
 
 private:
 
 	MeshElement * first;
 	MeshElement * second;
 
+	// unmeshed contact resistance folded into this link, zero unless it crosses a block interface [K/W]
+	double interfaceResistance;
+
 	// element-element thermal impedance
 	double resistanceAbsolute;
 };
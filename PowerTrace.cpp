@@ -0,0 +1,201 @@
+// A block's heat generation as a function of time, read from a text file.
+// Samples are streamed in fixed-size chunks, with the next chunk prefetched on a background thread.
+
+#include "PowerTrace.h"
+#include <sstream>
+#include <algorithm>
+
+PowerTrace::PowerTrace(std::string pathIn, int chunkSizeIn)
+{
+	path = pathIn;
+	chunkSize = chunkSizeIn;
+	cursor = 0;
+	endTime = 0;
+	segmentStart.time = 0;
+	segmentStart.power = 0;
+	segmentEnd = segmentStart;
+
+	file.open(path.c_str(), std::ios::in | std::ios::binary);
+	open = file.is_open();
+
+	if (!open) {
+		return;
+	}
+
+	endTime = readEndTime();
+
+	currChunk = readChunk();
+	if (currChunk.empty()) {
+		open = false;
+		return;
+	}
+
+	if ((int)currChunk.size() == chunkSize) {
+		prefetchNextChunk();
+	}
+
+	segmentStart = currChunk[0];
+	segmentEnd = currChunk[0];
+	cursor = 1;
+}
+
+// Waits for any outstanding prefetch so the reader thread never outlives the file
+PowerTrace::~PowerTrace()
+{
+	if (nextChunk.valid()) {
+		nextChunk.wait();
+	}
+}
+
+bool PowerTrace::isOpen()
+{
+	return open;
+}
+
+std::string PowerTrace::getPath()
+{
+	return path;
+}
+
+double PowerTrace::getEndTime()
+{
+	return endTime;
+}
+
+void PowerTrace::rewind()
+{
+	if (!open) {
+		return;
+	}
+
+	if (nextChunk.valid()) {
+		nextChunk.wait();
+		nextChunk = std::future<std::vector<TraceSample> >();
+	}
+
+	file.clear();
+	file.seekg(0);
+
+	currChunk = readChunk();
+	if ((int)currChunk.size() == chunkSize) {
+		prefetchNextChunk();
+	}
+
+	segmentStart = currChunk[0];
+	segmentEnd = currChunk[0];
+	cursor = 1;
+}
+
+// Accepts "time power" or "time,power", skips comments and blank lines
+bool PowerTrace::parseLine(std::string line, TraceSample & sample)
+{
+	if (line.empty() || line[0] == '#') {
+		return false;
+	}
+
+	std::replace(line.begin(), line.end(), ',', ' ');
+	std::istringstream fields(line);
+
+	return static_cast<bool>(fields >> sample.time >> sample.power);
+}
+
+// Reads up to chunkSize samples from where the previous chunk left off
+std::vector<PowerTrace::TraceSample> PowerTrace::readChunk()
+{
+	std::vector<TraceSample> chunk;
+	chunk.reserve(chunkSize);
+
+	std::string line;
+	TraceSample sample;
+
+	while ((int)chunk.size() < chunkSize && std::getline(file, line)) {
+		if (parseLine(line, sample)) {
+			chunk.push_back(sample);
+		}
+	}
+
+	return chunk;
+}
+
+void PowerTrace::prefetchNextChunk()
+{
+	nextChunk = std::async(std::launch::async, &PowerTrace::readChunk, this);
+}
+
+// Hands out samples in file order, swapping in the prefetched chunk when the current one runs out
+bool PowerTrace::nextSample(TraceSample & sample)
+{
+	if (cursor >= currChunk.size()) {
+
+		if (!nextChunk.valid()) {
+			return false;
+		}
+
+		currChunk = nextChunk.get();
+		cursor = 0;
+
+		if (currChunk.empty()) {
+			return false;
+		}
+
+		if ((int)currChunk.size() == chunkSize) {
+			prefetchNextChunk();
+		}
+	}
+
+	sample = currChunk[cursor];
+	cursor++;
+	return true;
+}
+
+double PowerTrace::getPower(double time)
+{
+	if (!open) {
+		return 0;
+	}
+
+	TraceSample sample;
+	while (time > segmentEnd.time && nextSample(sample)) {
+		segmentStart = segmentEnd;
+		segmentEnd = sample;
+	}
+
+	if (time <= segmentStart.time) {
+		return segmentStart.power;
+	}
+
+	if (time >= segmentEnd.time) {
+		return segmentEnd.power;
+	}
+
+	double fraction = (time - segmentStart.time) / (segmentEnd.time - segmentStart.time);
+	return segmentStart.power + fraction * (segmentEnd.power - segmentStart.power);
+}
+
+// Reads just the tail of the file to find the final sample, so the trace length is known without a full pass
+double PowerTrace::readEndTime()
+{
+	file.seekg(0, std::ios::end);
+	std::streamoff fileSize = file.tellg();
+	std::streamoff tailSize = std::min<std::streamoff>(fileSize, 4096);
+
+	std::string tail(tailSize, '\0');
+	file.seekg(fileSize - tailSize);
+	file.read(&tail[0], tailSize);
+
+	file.clear();
+	file.seekg(0);
+
+	double lastTime = 0;
+	std::istringstream tailLines(tail);
+	std::string line;
+	TraceSample sample;
+
+	while (std::getline(tailLines, line)) {
+		if (parseLine(line, sample)) {
+			lastTime = sample.time;
+		}
+	}
+
+	return lastTime;
+}
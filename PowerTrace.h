@@ -0,0 +1,68 @@
+// A block's heat generation as a function of time, read from a text file.
+// Each line holds a time [sec] and a power [W] separated by whitespace or a comma. Lines starting with # are skipped.
+// Times must increase. Power is interpolated linearly between samples and held flat outside the trace.
+//
+// Traces may be far larger than memory allows, so they are streamed: samples are read in fixed-size chunks and the
+// next chunk is prefetched on a background thread while the current one is being consumed.
+// Lookups must move forward in time, as they do when marching a transient solution.
+
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <future>
+
+class PowerTrace
+{
+
+public:
+
+	PowerTrace(std::string pathIn, int chunkSizeIn = 65536);
+
+	~PowerTrace();
+
+	bool isOpen();
+
+	// Interpolated power at the given time [W], time must not decrease between calls
+	double getPower(double time);
+
+	// Starts over from the first sample, for re-running a transient
+	void rewind();
+
+	// Time of the last sample in the file [sec]
+	double getEndTime();
+
+	std::string getPath();
+
+private:
+
+	struct TraceSample {
+		double time;
+		double power;
+	};
+
+	static bool parseLine(std::string line, TraceSample & sample);
+
+	std::vector<TraceSample> readChunk();
+
+	void prefetchNextChunk();
+
+	bool nextSample(TraceSample & sample);
+
+	double readEndTime();
+
+	std::string path;
+	std::ifstream file;
+	bool open;
+	int chunkSize;
+
+	std::vector<TraceSample> currChunk;
+	std::future<std::vector<TraceSample> > nextChunk;	// invalid once the file has been read to the end
+	unsigned int cursor;								// next unread sample within currChunk
+
+	// the two samples bracketing the most recent lookup, may straddle a chunk boundary
+	TraceSample segmentStart;
+	TraceSample segmentEnd;
+
+	double endTime;
+};
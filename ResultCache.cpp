@@ -0,0 +1,174 @@
+// On-disk cache of solved temperature fields, keyed by a hash of the stack's canonical configuration.
+
+#include "ResultCache.h"
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <thread>
+#include <functional>
+#include <chrono>
+
+static const char * entryHeader = "ThermalStackFEA result cache 2";
+
+ResultCache::ResultCache(std::string directoryIn)
+{
+	directory = directoryIn;
+	if (!directory.empty() && directory.back() != '/' && directory.back() != '\\') {
+		directory += '/';
+	}
+}
+
+ResultCache::~ResultCache()
+{
+}
+
+static void hashBytes(unsigned long long & value, const char * bytes, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		value ^= (unsigned char)bytes[i];
+		value *= 1099511628211ULL;
+	}
+}
+
+static std::string hexDigits(unsigned long long value)
+{
+	char digits[17];
+	snprintf(digits, sizeof(digits), "%016llx", value);
+	return digits;
+}
+
+std::string ResultCache::hash(const std::string & text)
+{
+	unsigned long long value = 14695981039346656037ULL;
+	hashBytes(value, text.data(), text.size());
+	return hexDigits(value);
+}
+
+std::string ResultCache::hashFile(const std::string & path)
+{
+	std::ifstream file(path.c_str(), std::ios::binary);
+	if (!file) {
+		return "";
+	}
+
+	unsigned long long value = 14695981039346656037ULL;
+	char chunk[65536];
+
+	while (file.read(chunk, sizeof(chunk)) || file.gcount() > 0) {
+		hashBytes(value, chunk, (size_t)file.gcount());
+	}
+	return hexDigits(value);
+}
+
+std::string ResultCache::entryPath(const std::string & key)
+{
+	return directory + key + ".result";
+}
+
+std::string ResultCache::latestPath(const std::string & geometryKey)
+{
+	return directory + geometryKey + ".latest";
+}
+
+bool ResultCache::load(const std::string & configuration, CachedResult & result)
+{
+	return readEntry(entryPath(hash(configuration)), &configuration, result);
+}
+
+bool ResultCache::loadLatestWithGeometry(const std::string & geometry, CachedResult & result)
+{
+	std::ifstream pointer(latestPath(hash(geometry)).c_str());
+	std::string key;
+	if (!(pointer >> key)) {
+		return false;
+	}
+
+	return readEntry(entryPath(key), nullptr, result);
+}
+
+// Layout: header line, configuration length and text, the reported figures, then the field as raw doubles
+bool ResultCache::readEntry(const std::string & path, const std::string * expectedConfiguration, CachedResult & result)
+{
+	std::ifstream in(path.c_str(), std::ios::binary);
+	if (!in) {
+		return false;
+	}
+
+	std::string header;
+	std::getline(in, header);
+	if (header != entryHeader) {
+		return false;
+	}
+
+	size_t configurationLength = 0;
+	in >> configurationLength;
+	in.get();
+
+	std::string configuration(configurationLength, '\0');
+	in.read(&configuration[0], configurationLength);
+	if (!in || (expectedConfiguration != nullptr && configuration != *expectedConfiguration)) {
+		return false;
+	}
+
+	int steady = 0;
+	size_t temperatureCount = 0;
+	in >> steady >> result.time >> result.monitoredTemperature >> result.tauTime >> result.tauTemperature
+	   >> result.thermalImpedance >> temperatureCount;
+	in.get();
+	result.steady = (steady != 0);
+
+	result.temperatures.resize(temperatureCount);
+	if (temperatureCount > 0) {
+		in.read((char *)&result.temperatures[0], temperatureCount * sizeof(double));
+	}
+
+	return (bool)in;
+}
+
+bool ResultCache::store(const std::string & configuration, const std::string & geometry, const CachedResult & result)
+{
+	std::ostringstream out(std::ios::binary);
+	out.precision(17);
+
+	out << entryHeader << "\n";
+	out << configuration.size() << "\n" << configuration;
+	out << (result.steady ? 1 : 0) << " " << result.time << " " << result.monitoredTemperature << " "
+		<< result.tauTime << " " << result.tauTemperature << " " << result.thermalImpedance << " "
+		<< result.temperatures.size() << "\n";
+	if (!result.temperatures.empty()) {
+		out.write((const char *)&result.temperatures[0], result.temperatures.size() * sizeof(double));
+	}
+
+	std::string key = hash(configuration);
+
+	return writeAtomically(entryPath(key), out.str()) &&
+		   writeAtomically(latestPath(hash(geometry)), key + "\n");
+}
+
+bool ResultCache::writeAtomically(const std::string & path, const std::string & contents)
+{
+	std::ostringstream temporaryName;
+	temporaryName << path << ".tmp" << std::hash<std::thread::id>()(std::this_thread::get_id())
+				  << "-" << std::chrono::steady_clock::now().time_since_epoch().count();
+	std::string temporaryPath = temporaryName.str();
+
+	{
+		std::ofstream out(temporaryPath.c_str(), std::ios::binary);
+		out.write(contents.data(), contents.size());
+		if (!out) {
+			std::remove(temporaryPath.c_str());
+			return false;
+		}
+	}
+
+#ifdef _WIN32
+	// rename() will not replace an existing file here, so a reader may briefly miss the entry
+	std::remove(path.c_str());
+#endif
+	if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+		std::remove(temporaryPath.c_str());
+		return false;
+	}
+
+	return true;
+}
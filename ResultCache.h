@@ -0,0 +1,61 @@
+// On-disk cache of solved temperature fields, keyed by a hash of the stack's canonical configuration.
+// Each entry also records a geometry key, so that a stack differing only in power, materials or boundary
+// temperatures can find the most recent entry with the same mesh and start from its field.
+//
+// Entries store their canonical configuration text, so a hash collision is detected rather than returned.
+// Files are written under a temporary name and renamed into place, so concurrent runs never read half an entry.
+//
+// Example Usage:
+//
+//		myThermalCircuit.enableResultCache("cache/");
+
+#pragma once
+#include <string>
+#include <vector>
+
+// A solved field and the figures reported with it
+struct CachedResult {
+	bool steady;					// from solveSteady() rather than solve()
+	double time;					// simulated time at convergence [sec]
+	double monitoredTemperature;	// [C]
+	double tauTime;					// one time constant, transient only [sec]
+	double tauTemperature;			// [C]
+	double thermalImpedance;		// [K/W]
+	std::vector<double> temperatures;	// active elements in array order [C]
+};
+
+class ResultCache
+{
+
+public:
+
+	ResultCache(std::string directoryIn);
+
+	~ResultCache();
+
+	// 64-bit FNV-1a, as 16 hex digits
+	static std::string hash(const std::string & text);
+
+	// Hash of a file's bytes, read in chunks; empty if it cannot be read
+	static std::string hashFile(const std::string & path);
+
+	// Exact lookup; true only if an entry with this configuration exists and reads back whole
+	bool load(const std::string & configuration, CachedResult & result);
+
+	// Most recently stored entry with this geometry, whatever its configuration
+	bool loadLatestWithGeometry(const std::string & geometry, CachedResult & result);
+
+	bool store(const std::string & configuration, const std::string & geometry, const CachedResult & result);
+
+private:
+
+	std::string entryPath(const std::string & key);
+
+	std::string latestPath(const std::string & geometryKey);
+
+	bool readEntry(const std::string & path, const std::string * expectedConfiguration, CachedResult & result);
+
+	bool writeAtomically(const std::string & path, const std::string & contents);
+
+	std::string directory;
+};
@@ -0,0 +1,108 @@
+// Estimates the discretization error in one result solved at several mesh sizes.
+
+#include "RichardsonExtrapolation.h"
+#include <cmath>
+#include <algorithm>
+
+RichardsonExtrapolation::RichardsonExtrapolation(std::vector<double> meshSizesIn, std::vector<double> valuesIn, double formalOrderIn)
+{
+	meshSizes = meshSizesIn;
+	values = valuesIn;
+	formalOrder = formalOrderIn;
+	order = formalOrder;
+	orderObserved = false;
+	extrapolatedValue = 0;
+
+	for (unsigned int i = 0; i < meshSizes.size(); i++) {
+		finestFirst.push_back(i);
+	}
+	std::sort(finestFirst.begin(), finestFirst.end(), [&](int first, int second) {
+		return meshSizes[first] < meshSizes[second];
+	});
+
+	if (finestFirst.empty()) {
+		return;
+	}
+
+	extrapolatedValue = values[finestFirst[0]];
+
+	if (finestFirst.size() < 2) {
+		return;
+	}
+
+	estimateOrder();
+
+	double h1 = meshSizes[finestFirst[0]];
+	double h2 = meshSizes[finestFirst[1]];
+	double f1 = values[finestFirst[0]];
+	double f2 = values[finestFirst[1]];
+
+	double ratioToOrder = pow(h2 / h1, order);
+	extrapolatedValue = (ratioToOrder * f1 - f2) / (ratioToOrder - 1);
+}
+
+RichardsonExtrapolation::~RichardsonExtrapolation()
+{
+}
+
+// Fixed-point iteration for p over the three finest meshes, after Celik et al.
+void RichardsonExtrapolation::estimateOrder()
+{
+	if (finestFirst.size() < 3) {
+		return;
+	}
+
+	double h1 = meshSizes[finestFirst[0]];
+	double h2 = meshSizes[finestFirst[1]];
+	double h3 = meshSizes[finestFirst[2]];
+	double e21 = values[finestFirst[1]] - values[finestFirst[0]];
+	double e32 = values[finestFirst[2]] - values[finestFirst[1]];
+
+	// identical results, or oscillating ones, say nothing about the order
+	if (e21 == 0 || e32 == 0 || e32 / e21 < 0 || h2 == h1 || h3 == h2) {
+		return;
+	}
+
+	double r21 = h2 / h1;
+	double r32 = h3 / h2;
+
+	double p = formalOrder;
+	for (int iteration = 0; iteration < 50; iteration++) {
+		double q = log((pow(r21, p) - 1) / (pow(r32, p) - 1));
+		double pNext = fabs(log(fabs(e32 / e21)) + q) / log(r21);
+		if (fabs(pNext - p) < 1e-6) {
+			p = pNext;
+			break;
+		}
+		p = pNext;
+	}
+
+	// outside this range the meshes are too coarse for the asymptotic assumption to hold
+	if (std::isfinite(p) && p >= 0.5 && p <= 2 * formalOrder) {
+		order = p;
+		orderObserved = true;
+	}
+}
+
+double RichardsonExtrapolation::getExtrapolatedValue() { return extrapolatedValue; }
+double RichardsonExtrapolation::getObservedOrder() { return order; }
+bool RichardsonExtrapolation::isOrderObserved() { return orderObserved; }
+
+double RichardsonExtrapolation::getErrorEstimate(int i)
+{
+	return fabs(values[i] - extrapolatedValue);
+}
+
+double RichardsonExtrapolation::predictMeshSize(double errorTarget)
+{
+	if (finestFirst.size() < 2) {
+		return 0;
+	}
+
+	double finestError = getErrorEstimate(finestFirst[0]);
+	if (finestError == 0 || errorTarget <= 0) {
+		return 0;
+	}
+
+	return meshSizes[finestFirst[0]] * pow(errorTarget / finestError, 1 / order);
+}
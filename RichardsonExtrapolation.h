@@ -0,0 +1,49 @@
+// Estimates the discretization error in one result solved at several mesh sizes.
+// The error is assumed to fall as C * h^p. With three or more meshes the order p is taken from the three finest,
+// allowing for uneven refinement ratios; with two, or when the results oscillate, the formal order is used.
+//
+// Example Usage:
+//
+//		RichardsonExtrapolation impedance(meshSizes, impedances);
+//		double error = impedance.getErrorEstimate(0);
+
+#pragma once
+#include <vector>
+
+class RichardsonExtrapolation
+{
+
+public:
+
+	// Mesh sizes in any order, values in the same order. Formal order 2 suits the element link scheme.
+	RichardsonExtrapolation(std::vector<double> meshSizesIn, std::vector<double> valuesIn, double formalOrderIn = 2);
+
+	~RichardsonExtrapolation();
+
+	// Estimate of the value at zero mesh size
+	double getExtrapolatedValue();
+
+	double getObservedOrder();
+
+	// False when the formal order had to stand in for an observed one
+	bool isOrderObserved();
+
+	// Estimated absolute error in the value at mesh size i, in the order given
+	double getErrorEstimate(int i);
+
+	// Mesh size expected to bring the absolute error down to errorTarget, 0 if it cannot be predicted
+	double predictMeshSize(double errorTarget);
+
+private:
+
+	void estimateOrder();
+
+	std::vector<double> meshSizes;
+	std::vector<double> values;
+	std::vector<int> finestFirst;	// indices into meshSizes, sorted by increasing size
+
+	double formalOrder;
+	double order;
+	bool orderObserved;
+	double extrapolatedValue;
+};
@@ -0,0 +1,193 @@
+// Optional run instrumentation for ThermalStack.
+// Records wall-clock time per phase, stepping throughput over time, peak resident memory and mesh footprint,
+// and writes the lot out as a JSON report at the end of a run.
+
+#include "RunInstrumentation.h"
+#include <fstream>
+#include <iomanip>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+RunInstrumentation::RunInstrumentation()
+{
+	runStart = Clock::now();
+
+	rateSampleIntervalSeconds = 1.0;
+	lastRateSampleAt = runStart;
+	lastRateSampleStep = 0;
+
+	activeElementCount = 0;
+	totalElementCount = 0;
+	linkCount = 0;
+	bytesPerElement = 0;
+	bytesPerLink = 0;
+
+	converged = false;
+	steps = 0;
+	time = 0;
+	monitoredTemperature = 0;
+	thermalImpedance = 0;
+}
+
+RunInstrumentation::~RunInstrumentation()
+{
+}
+
+RunInstrumentation::PhaseRecord * RunInstrumentation::findPhase(const std::string & phaseName)
+{
+	for (unsigned int i = 0; i < phases.size(); i++) {
+		if (phases[i].name == phaseName) {
+			return &phases[i];
+		}
+	}
+
+	PhaseRecord newPhase;
+	newPhase.name = phaseName;
+	newPhase.seconds = 0;
+	newPhase.running = false;
+	phases.push_back(newPhase);
+
+	return &phases.back();
+}
+
+void RunInstrumentation::startPhase(const std::string & phaseName)
+{
+	PhaseRecord * phase = findPhase(phaseName);
+	phase->startedAt = Clock::now();
+	phase->running = true;
+}
+
+void RunInstrumentation::stopPhase(const std::string & phaseName)
+{
+	PhaseRecord * phase = findPhase(phaseName);
+	if (phase->running) {
+		phase->seconds += std::chrono::duration<double>(Clock::now() - phase->startedAt).count();
+		phase->running = false;
+	}
+}
+
+void RunInstrumentation::addPhaseTime(const std::string & phaseName, double seconds)
+{
+	findPhase(phaseName)->seconds += seconds;
+}
+
+// Called at sample points; only keeps a sample once enough wall-clock time has passed so long runs stay small
+void RunInstrumentation::recordStepRate(long step, double time)
+{
+	Clock::time_point now = Clock::now();
+	double sinceLast = std::chrono::duration<double>(now - lastRateSampleAt).count();
+
+	if (sinceLast < rateSampleIntervalSeconds) {
+		return;
+	}
+
+	RateSample sample;
+	sample.wallSeconds = std::chrono::duration<double>(now - runStart).count();
+	sample.time = time;
+	sample.step = step;
+	sample.stepsPerSecond = (step - lastRateSampleStep) / sinceLast;
+	rateSamples.push_back(sample);
+
+	lastRateSampleAt = now;
+	lastRateSampleStep = step;
+}
+
+void RunInstrumentation::setMeshFootprint(int activeElementCountIn,
+										  int totalElementCountIn,
+										  int linkCountIn,
+										  double bytesPerElementIn,
+										  double bytesPerLinkIn)
+{
+	activeElementCount = activeElementCountIn;
+	totalElementCount = totalElementCountIn;
+	linkCount = linkCountIn;
+	bytesPerElement = bytesPerElementIn;
+	bytesPerLink = bytesPerLinkIn;
+}
+
+void RunInstrumentation::setResult(bool convergedIn, long stepsIn, double timeIn, double monitoredTemperatureIn, double thermalImpedanceIn)
+{
+	converged = convergedIn;
+	steps = stepsIn;
+	time = timeIn;
+	monitoredTemperature = monitoredTemperatureIn;
+	thermalImpedance = thermalImpedanceIn;
+}
+
+long long RunInstrumentation::peakResidentBytes()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return (long long)counters.PeakWorkingSetSize;
+	}
+	return 0;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+		return (long long)usage.ru_maxrss;			// bytes on macOS
+#else
+		return (long long)usage.ru_maxrss * 1024;	// kilobytes on Linux
+#endif
+	}
+	return 0;
+#endif
+}
+
+bool RunInstrumentation::writeJsonReport(const std::string & path)
+{
+	std::ofstream out(path.c_str());
+	if (!out) {
+		return false;
+	}
+
+	double wallSeconds = std::chrono::duration<double>(Clock::now() - runStart).count();
+
+	out << std::setprecision(9);
+	out << "{\n";
+	out << "  \"wall_seconds\": " << wallSeconds << ",\n";
+
+	out << "  \"phases\": {";
+	for (unsigned int i = 0; i < phases.size(); i++) {
+		out << (i == 0 ? "\n" : ",\n");
+		out << "    \"" << phases[i].name << "\": " << phases[i].seconds;
+	}
+	out << "\n  },\n";
+
+	out << "  \"mesh\": {\n";
+	out << "    \"active_elements\": " << activeElementCount << ",\n";
+	out << "    \"total_elements\": " << totalElementCount << ",\n";
+	out << "    \"links\": " << linkCount << ",\n";
+	out << "    \"bytes_per_element\": " << bytesPerElement << ",\n";
+	out << "    \"bytes_per_link\": " << bytesPerLink << "\n";
+	out << "  },\n";
+
+	out << "  \"peak_resident_bytes\": " << peakResidentBytes() << ",\n";
+
+	out << "  \"step_rate\": [";
+	for (unsigned int i = 0; i < rateSamples.size(); i++) {
+		out << (i == 0 ? "\n" : ",\n");
+		out << "    {\"wall_seconds\": " << rateSamples[i].wallSeconds
+			<< ", \"time\": " << rateSamples[i].time
+			<< ", \"step\": " << rateSamples[i].step
+			<< ", \"steps_per_second\": " << rateSamples[i].stepsPerSecond << "}";
+	}
+	out << "\n  ],\n";
+
+	out << "  \"result\": {\n";
+	out << "    \"converged\": " << (converged ? "true" : "false") << ",\n";
+	out << "    \"steps\": " << steps << ",\n";
+	out << "    \"time\": " << time << ",\n";
+	out << "    \"monitored_temperature\": " << monitoredTemperature << ",\n";
+	out << "    \"thermal_impedance\": " << thermalImpedance << "\n";
+	out << "  }\n";
+	out << "}\n";
+
+	return out.good();
+}
@@ -0,0 +1,100 @@
+// Optional run instrumentation for ThermalStack.
+// Records wall-clock time per phase, stepping throughput over time, peak resident memory and mesh footprint,
+// and writes the lot out as a JSON report at the end of a run.
+//
+// Example Usage:
+//
+//		myThermalCircuit.enableInstrumentation("run_report.json");
+//		myThermalCircuit.setProgressCallback(myCallback, 5.0);	// at most once every 5 wall-clock seconds
+
+#pragma once
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+
+// Snapshot handed to the progress callback at sample points
+struct SolveProgress {
+	long step;						// time steps taken so far
+	double time;					// simulated time [sec]
+	double monitoredTemperature;	// mean temperature of the monitored block [C]
+	double dTdt;					// current rate of change of the monitored temperature [C/sec]
+	double stepsPerSecond;			// wall-clock stepping throughput since the previous callback
+};
+
+// Runs on the solver's reporter thread, see ThermalStack::setProgressCallback()
+typedef std::function<void(const SolveProgress &)> ProgressCallback;
+
+class RunInstrumentation
+{
+
+public:
+
+	RunInstrumentation();
+
+	~RunInstrumentation();
+
+	// Accumulates wall-clock time under the given phase name
+	void startPhase(const std::string & phaseName);
+	void stopPhase(const std::string & phaseName);
+
+	// Adds an externally measured duration to a phase
+	void addPhaseTime(const std::string & phaseName, double seconds);
+
+	// Records stepping throughput, thinned to one sample per rateSampleIntervalSeconds of wall-clock time
+	void recordStepRate(long step, double time);
+
+	void setMeshFootprint(int activeElementCount,
+						  int totalElementCount,
+						  int linkCount,
+						  double bytesPerElement,
+						  double bytesPerLink);
+
+	void setResult(bool converged, long steps, double time, double monitoredTemperature, double thermalImpedance);
+
+	// Peak resident set size of this process [bytes], 0 if unavailable on this platform
+	static long long peakResidentBytes();
+
+	bool writeJsonReport(const std::string & path);
+
+private:
+
+	typedef std::chrono::steady_clock Clock;
+
+	struct PhaseRecord {
+		std::string name;
+		double seconds;
+		Clock::time_point startedAt;
+		bool running;
+	};
+
+	struct RateSample {
+		double wallSeconds;
+		double time;
+		long step;
+		double stepsPerSecond;
+	};
+
+	PhaseRecord * findPhase(const std::string & phaseName);
+
+	Clock::time_point runStart;
+
+	std::vector<PhaseRecord> phases;
+
+	double rateSampleIntervalSeconds;
+	std::vector<RateSample> rateSamples;
+	Clock::time_point lastRateSampleAt;
+	long lastRateSampleStep;
+
+	int activeElementCount;
+	int totalElementCount;
+	int linkCount;
+	double bytesPerElement;
+	double bytesPerLink;
+
+	bool converged;
+	long steps;
+	double time;
+	double monitoredTemperature;
+	double thermalImpedance;
+};
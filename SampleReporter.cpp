@@ -0,0 +1,75 @@
+// Moves per-sample reporting off the stepping thread.
+// Snapshots alternate between two buffers; the reporter thread handles them in publication order.
+
+#include "SampleReporter.h"
+
+SampleReporter::SampleReporter(SampleHandler handlerIn)
+{
+	handler = handlerIn;
+	publishedCount = 0;
+	handledCount = 0;
+	stopping = false;
+
+	reporterThread = std::thread(&SampleReporter::run, this);
+}
+
+SampleReporter::~SampleReporter()
+{
+	{
+		std::lock_guard<std::mutex> lock(bufferMutex);
+		stopping = true;
+	}
+	bufferChanged.notify_all();
+
+	reporterThread.join();
+}
+
+void SampleReporter::publish(const MonitorSample & sample)
+{
+	std::unique_lock<std::mutex> lock(bufferMutex);
+
+	while (publishedCount - handledCount >= 2) {
+		bufferChanged.wait(lock);
+	}
+
+	buffers[publishedCount % 2] = sample;
+	publishedCount++;
+
+	lock.unlock();
+	bufferChanged.notify_all();
+}
+
+void SampleReporter::drain()
+{
+	std::unique_lock<std::mutex> lock(bufferMutex);
+
+	while (handledCount < publishedCount) {
+		bufferChanged.wait(lock);
+	}
+}
+
+// Reporter thread: waits for a snapshot, handles it outside the lock, then frees its buffer
+void SampleReporter::run()
+{
+	std::unique_lock<std::mutex> lock(bufferMutex);
+
+	while (true) {
+
+		while (handledCount == publishedCount && !stopping) {
+			bufferChanged.wait(lock);
+		}
+
+		if (handledCount == publishedCount && stopping) {
+			return;
+		}
+
+		MonitorSample sample = buffers[handledCount % 2];
+
+		lock.unlock();
+		handler(sample);
+		lock.lock();
+
+		handledCount++;
+		bufferChanged.notify_all();
+	}
+}
@@ -0,0 +1,55 @@
+// Moves per-sample reporting off the stepping thread.
+// At each sample point the solver publishes a small snapshot of the monitored quantities; a reporter thread picks it up
+// and does the history bookkeeping, statistics and output. Snapshots go through two alternating buffers, so the
+// solver only blocks if the reporter falls two samples behind, or when it explicitly waits for the reporter to catch up.
+
+#pragma once
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+// What the solver hands over at a sample point
+struct MonitorSample {
+	long step;
+	double time;						// simulated time [sec]
+	double monitoredTemperature;		// mean temperature of the monitored block [C]
+	double dTdt;						// change since the previous sample [C/sec]
+	std::chrono::steady_clock::time_point sampledAt;
+};
+
+typedef std::function<void(const MonitorSample &)> SampleHandler;
+
+class SampleReporter
+{
+
+public:
+
+	// Starts the reporter thread, handlerIn runs on that thread once per published sample, in order
+	SampleReporter(SampleHandler handlerIn);
+
+	// Handles anything still pending, then stops the reporter thread
+	~SampleReporter();
+
+	// Copies the sample into the free buffer and returns, waiting only if both buffers are still pending
+	void publish(const MonitorSample & sample);
+
+	// Blocks until every published sample has been handled
+	void drain();
+
+private:
+
+	void run();
+
+	SampleHandler handler;
+
+	MonitorSample buffers[2];
+	long publishedCount;
+	long handledCount;
+	bool stopping;
+
+	std::mutex bufferMutex;
+	std::condition_variable bufferChanged;
+	std::thread reporterThread;
+};
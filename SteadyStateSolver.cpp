@@ -0,0 +1,148 @@
+// Solves the steady-state conduction system G * T = q directly, without time marching.
+
+#include "SteadyStateSolver.h"
+#include <cmath>
+
+SteadyStateSolver::SteadyStateSolver(int unknownCountIn)
+{
+	unknownCount = unknownCountIn;
+	diagonal.assign(unknownCount, 0);
+	load.assign(unknownCount, 0);
+}
+
+SteadyStateSolver::~SteadyStateSolver()
+{
+}
+
+void SteadyStateSolver::addLink(int first, int second, double conductance)
+{
+	Edge edge;
+	edge.first = first;
+	edge.second = second;
+	edge.conductance = conductance;
+	edges.push_back(edge);
+
+	diagonal[first] += conductance;
+	diagonal[second] += conductance;
+}
+
+void SteadyStateSolver::addBoundary(int unknown, double conductance, double ambientTemperature)
+{
+	BoundaryTerm boundary;
+	boundary.unknown = unknown;
+	boundary.conductance = conductance;
+	boundary.ambientTemperature = ambientTemperature;
+	boundaries.push_back(boundary);
+
+	diagonal[unknown] += conductance;
+	load[unknown] += conductance * ambientTemperature;
+}
+
+void SteadyStateSolver::setLinkConductance(int link, double conductance)
+{
+	Edge & edge = edges[link];
+	double change = conductance - edge.conductance;
+
+	diagonal[edge.first] += change;
+	diagonal[edge.second] += change;
+	edge.conductance = conductance;
+}
+
+void SteadyStateSolver::setBoundaryConductance(int boundary, double conductance)
+{
+	BoundaryTerm & term = boundaries[boundary];
+	double change = conductance - term.conductance;
+
+	diagonal[term.unknown] += change;
+	load[term.unknown] += change * term.ambientTemperature;
+	term.conductance = conductance;
+}
+
+void SteadyStateSolver::addSource(int unknown, double q)
+{
+	load[unknown] += q;
+}
+
+const std::vector<double> & SteadyStateSolver::getLoad() { return load; }
+int SteadyStateSolver::getUnknownCount() { return unknownCount; }
+
+void SteadyStateSolver::multiply(const std::vector<double> & x, std::vector<double> & result)
+{
+	result.resize(unknownCount);
+
+	for (int i = 0; i < unknownCount; i++) {
+		result[i] = diagonal[i] * x[i];
+	}
+
+	for (unsigned int e = 0; e < edges.size(); e++) {
+		result[edges[e].first] -= edges[e].conductance * x[edges[e].second];
+		result[edges[e].second] -= edges[e].conductance * x[edges[e].first];
+	}
+}
+
+// Jacobi-preconditioned conjugate gradients
+int SteadyStateSolver::solve(const std::vector<double> & rhs, std::vector<double> & x, double relativeTolerance, int maxIterations)
+{
+	x.resize(unknownCount, 0);
+
+	std::vector<double> residual(unknownCount);
+	std::vector<double> preconditioned(unknownCount);
+	std::vector<double> direction(unknownCount);
+	std::vector<double> product(unknownCount);
+
+	multiply(x, product);
+
+	double rhsNorm = 0;
+	double residualDotPreconditioned = 0;
+
+	for (int i = 0; i < unknownCount; i++) {
+		residual[i] = rhs[i] - product[i];
+		preconditioned[i] = residual[i] / diagonal[i];
+		direction[i] = preconditioned[i];
+		residualDotPreconditioned += residual[i] * preconditioned[i];
+		rhsNorm += rhs[i] * rhs[i];
+	}
+
+	rhsNorm = sqrt(rhsNorm);
+	if (rhsNorm == 0) {
+		rhsNorm = 1;
+	}
+
+	for (int iteration = 0; iteration < maxIterations; iteration++) {
+
+		double residualNorm = 0;
+		for (int i = 0; i < unknownCount; i++) {
+			residualNorm += residual[i] * residual[i];
+		}
+
+		if (sqrt(residualNorm) <= relativeTolerance * rhsNorm) {
+			return iteration;
+		}
+
+		multiply(direction, product);
+
+		double directionDotProduct = 0;
+		for (int i = 0; i < unknownCount; i++) {
+			directionDotProduct += direction[i] * product[i];
+		}
+
+		double stepLength = residualDotPreconditioned / directionDotProduct;
+
+		double nextResidualDotPreconditioned = 0;
+		for (int i = 0; i < unknownCount; i++) {
+			x[i] += stepLength * direction[i];
+			residual[i] -= stepLength * product[i];
+			preconditioned[i] = residual[i] / diagonal[i];
+			nextResidualDotPreconditioned += residual[i] * preconditioned[i];
+		}
+
+		double directionUpdate = nextResidualDotPreconditioned / residualDotPreconditioned;
+		residualDotPreconditioned = nextResidualDotPreconditioned;
+
+		for (int i = 0; i < unknownCount; i++) {
+			direction[i] = preconditioned[i] + directionUpdate * direction[i];
+		}
+	}
+
+	return -1;
+}
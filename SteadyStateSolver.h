@@ -0,0 +1,64 @@
+// Solves the steady-state conduction system G * T = q directly, without time marching.
+// G is assembled from the same element links and convection boundaries the transient solver steps,
+// and is symmetric positive definite as long as at least one convection boundary ties the model to an ambient.
+//
+// Unknowns are numbered densely over the active elements. G is kept as an edge list plus its diagonal,
+// which is all that Jacobi-preconditioned conjugate gradients needs.
+
+#pragma once
+#include <vector>
+
+class SteadyStateSolver
+{
+
+public:
+
+	SteadyStateSolver(int unknownCountIn);
+
+	~SteadyStateSolver();
+
+	// Conductance between two unknowns [W/K]
+	void addLink(int first, int second, double conductance);
+
+	// Conductance from an unknown to a fixed ambient temperature [W/K], [C]
+	void addBoundary(int unknown, double conductance, double ambientTemperature);
+
+	// Heat generated at an unknown [W]
+	void addSource(int unknown, double q);
+
+	// Change the conductance of the link or boundary added at the given position, in place.
+	// The diagonal, and with it the Jacobi preconditioner, is patched rather than rebuilt
+	void setLinkConductance(int link, double conductance);
+	void setBoundaryConductance(int boundary, double conductance);
+
+	// Solves G * x = rhs; x holds the initial guess on entry. Returns the iteration count, or -1 if not converged
+	int solve(const std::vector<double> & rhs, std::vector<double> & x, double relativeTolerance, int maxIterations);
+
+	// result = G * x
+	void multiply(const std::vector<double> & x, std::vector<double> & result);
+
+	// The assembled q, including ambient contributions from the boundaries
+	const std::vector<double> & getLoad();
+
+	int getUnknownCount();
+
+private:
+
+	struct Edge {
+		int first;
+		int second;
+		double conductance;
+	};
+
+	struct BoundaryTerm {
+		int unknown;
+		double conductance;
+		double ambientTemperature;
+	};
+
+	int unknownCount;
+	std::vector<Edge> edges;
+	std::vector<BoundaryTerm> boundaries;
+	std::vector<double> diagonal;
+	std::vector<double> load;
+};
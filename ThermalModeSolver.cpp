@@ -0,0 +1,279 @@
+// Finds the slowest thermal eigenmodes of a conduction system, C dT/dt = -G T + q, without time marching.
+
+#include "ThermalModeSolver.h"
+#include <cmath>
+#include <random>
+#include <algorithm>
+
+ThermalModeSolver::ThermalModeSolver(SteadyStateSolver & conductanceIn, std::vector<double> capacitanceIn)
+	: conductance(conductanceIn)
+{
+	capacitanceRoot.resize(capacitanceIn.size());
+	for (unsigned int i = 0; i < capacitanceIn.size(); i++) {
+		capacitanceRoot[i] = sqrt(capacitanceIn[i]);
+	}
+
+	stepCount = 0;
+	unconvergedCount = 0;
+}
+
+ThermalModeSolver::~ThermalModeSolver()
+{
+}
+
+int ThermalModeSolver::getStepCount() { return stepCount; }
+
+int ThermalModeSolver::getUnconvergedCount() { return unconvergedCount; }
+
+// out = C^1/2 G^-1 C^1/2 in, whose eigenvalues are the time constants. False if the inner CG solve failed
+bool ThermalModeSolver::applyOperator(const std::vector<double> & in, std::vector<double> & out)
+{
+	int n = capacitanceRoot.size();
+
+	std::vector<double> scaled(n);
+	for (int i = 0; i < n; i++) {
+		scaled[i] = capacitanceRoot[i] * in[i];
+	}
+
+	std::vector<double> solution(n, 0);
+	if (conductance.solve(scaled, solution, 1e-10, 20 * n + 100) < 0) {
+		return false;
+	}
+
+	out.resize(n);
+	for (int i = 0; i < n; i++) {
+		out[i] = capacitanceRoot[i] * solution[i];
+	}
+	return true;
+}
+
+// Implicit QL on a symmetric tridiagonal matrix. On return diagonal holds the eigenvalues
+// and column k of eigenvectors the eigenvector of eigenvalue k.
+void ThermalModeSolver::tridiagonalEigen(std::vector<double> & diagonal,
+										 std::vector<double> offDiagonal,
+										 std::vector<std::vector<double> > & eigenvectors)
+{
+	int n = diagonal.size();
+	std::vector<double> & d = diagonal;
+	std::vector<double> e(n, 0);
+	for (int i = 0; i + 1 < n; i++) {
+		e[i] = offDiagonal[i];
+	}
+
+	eigenvectors.assign(n, std::vector<double>(n, 0));
+	for (int i = 0; i < n; i++) {
+		eigenvectors[i][i] = 1;
+	}
+
+	for (int l = 0; l < n; l++) {
+
+		int iterations = 0;
+		int m;
+
+		do {
+			for (m = l; m < n - 1; m++) {
+				double scale = fabs(d[m]) + fabs(d[m + 1]);
+				if (fabs(e[m]) <= 1e-15 * scale) {
+					break;
+				}
+			}
+
+			if (m != l) {
+				if (iterations++ == 60) {
+					break;
+				}
+
+				double g = (d[l + 1] - d[l]) / (2 * e[l]);
+				double r = hypot(g, 1.0);
+				g = d[m] - d[l] + e[l] / (g + (g >= 0 ? r : -r));
+				double s = 1;
+				double c = 1;
+				double p = 0;
+
+				int i;
+				for (i = m - 1; i >= l; i--) {
+					double f = s * e[i];
+					double b = c * e[i];
+					r = hypot(f, g);
+					e[i + 1] = r;
+
+					if (r == 0) {
+						d[i + 1] -= p;
+						e[m] = 0;
+						break;
+					}
+
+					s = f / r;
+					c = g / r;
+					g = d[i + 1] - p;
+					r = (d[i] - g) * s + 2 * c * b;
+					p = s * r;
+					d[i + 1] = g + p;
+					g = c * r - b;
+
+					for (int k = 0; k < n; k++) {
+						f = eigenvectors[k][i + 1];
+						eigenvectors[k][i + 1] = s * eigenvectors[k][i] + c * f;
+						eigenvectors[k][i] = c * eigenvectors[k][i] - s * f;
+					}
+				}
+
+				if (r == 0 && i >= l) {
+					continue;
+				}
+
+				d[l] -= p;
+				e[l] = g;
+				e[m] = 0;
+			}
+		} while (m != l);
+	}
+}
+
+// Lanczos with full reorthogonalization, checking the Ritz residuals every few steps
+int ThermalModeSolver::solve(int modeCount, std::vector<double> & timeConstants, std::vector<std::vector<double> > & modes)
+{
+	int n = capacitanceRoot.size();
+	int maxSteps = std::min(n, 10 * modeCount + 50);
+	modeCount = std::min(modeCount, n);
+
+	timeConstants.clear();
+	modes.clear();
+	stepCount = 0;
+	unconvergedCount = 0;
+
+	if (modeCount <= 0) {
+		return 0;
+	}
+
+	// mostly uniform temperature, which the slowest mode resembles, plus a fixed pseudo-random part
+	// so that modes orthogonal to it are still found
+	std::mt19937 generator(1);
+	std::uniform_real_distribution<double> perturbation(-0.1, 0.1);
+
+	std::vector<double> q(n);
+	double norm = 0;
+	for (int i = 0; i < n; i++) {
+		q[i] = capacitanceRoot[i] * (1 + perturbation(generator));
+		norm += q[i] * q[i];
+	}
+	norm = sqrt(norm);
+	for (int i = 0; i < n; i++) {
+		q[i] /= norm;
+	}
+
+	std::vector<std::vector<double> > basis;
+	std::vector<double> alpha;
+	std::vector<double> beta;
+
+	std::vector<double> ritzValues;
+	std::vector<std::vector<double> > ritzVectors;
+	std::vector<int> order;
+	std::vector<bool> converged(modeCount, false);
+
+	std::vector<double> w;
+
+	for (int j = 0; j < maxSteps; j++) {
+
+		basis.push_back(q);
+		if (!applyOperator(q, w)) {
+			stepCount = j;
+			unconvergedCount = modeCount;
+			return -1;
+		}
+
+		double a = 0;
+		for (int i = 0; i < n; i++) {
+			a += q[i] * w[i];
+		}
+		alpha.push_back(a);
+
+		// two passes of classical Gram-Schmidt against the whole basis
+		for (int pass = 0; pass < 2; pass++) {
+			for (unsigned int k = 0; k < basis.size(); k++) {
+				double projection = 0;
+				for (int i = 0; i < n; i++) {
+					projection += basis[k][i] * w[i];
+				}
+				for (int i = 0; i < n; i++) {
+					w[i] -= projection * basis[k][i];
+				}
+			}
+		}
+
+		double b = 0;
+		for (int i = 0; i < n; i++) {
+			b += w[i] * w[i];
+		}
+		b = sqrt(b);
+
+		int steps = j + 1;
+		bool invariant = b <= 1e-12 * fabs(alpha[0]);
+		bool lastStep = steps == maxSteps;
+
+		// an invariant Krylov space holds all the modes there are to find, even if fewer than requested,
+		// and there is no next basis vector to normalize
+		if (invariant || lastStep || (steps >= modeCount && steps % 5 == 0)) {
+
+			int available = std::min(modeCount, steps);
+
+			ritzValues = alpha;
+			tridiagonalEigen(ritzValues, beta, ritzVectors);
+
+			order.resize(steps);
+			for (int k = 0; k < steps; k++) {
+				order[k] = k;
+			}
+			std::sort(order.begin(), order.end(), [&](int first, int second) {
+				return ritzValues[first] > ritzValues[second];
+			});
+
+			// residual of a Ritz pair is beta_j times the last component of its tridiagonal eigenvector
+			int convergedCount = 0;
+			converged.assign(modeCount, false);
+			for (int k = 0; k < available; k++) {
+				double residual = b * fabs(ritzVectors[steps - 1][order[k]]);
+				if (invariant || residual <= 1e-8 * ritzValues[order[0]]) {
+					converged[k] = true;
+					convergedCount++;
+				}
+			}
+
+			if (convergedCount == modeCount || invariant || lastStep) {
+				stepCount = steps;
+				break;
+			}
+		}
+
+		beta.push_back(b);
+		for (int i = 0; i < n; i++) {
+			q[i] = w[i] / b;
+		}
+	}
+
+	for (int k = 0; k < modeCount; k++) {
+
+		if (!converged[k]) {
+			unconvergedCount++;
+			continue;
+		}
+
+		std::vector<double> mode(n, 0);
+		for (int s = 0; s < stepCount; s++) {
+			double component = ritzVectors[s][order[k]];
+			for (int i = 0; i < n; i++) {
+				mode[i] += component * basis[s][i];
+			}
+		}
+
+		// back from the symmetric form, v = C^-1/2 y
+		for (int i = 0; i < n; i++) {
+			mode[i] /= capacitanceRoot[i];
+		}
+
+		timeConstants.push_back(ritzValues[order[k]]);
+		modes.push_back(mode);
+	}
+
+	return timeConstants.size();
+}
@@ -0,0 +1,46 @@
+// Finds the slowest thermal eigenmodes of a conduction system, C dT/dt = -G T + q, without time marching.
+// Each mode v satisfies G v = lambda C v and decays as exp(-t / tau) with time constant tau = 1 / lambda.
+//
+// The slowest modes are the largest eigenvalues of the symmetric operator C^1/2 G^-1 C^1/2, which Lanczos
+// iteration picks out in a few dozen steps. Every step applies G^-1 through the steady-state CG solver.
+// The Lanczos basis is fully reorthogonalized, so memory grows as steps * unknowns.
+
+#pragma once
+#include "SteadyStateSolver.h"
+#include <vector>
+
+class ThermalModeSolver
+{
+
+public:
+
+	// capacitanceIn holds each unknown's heat capacity [J/K], in the conductance system's numbering
+	ThermalModeSolver(SteadyStateSolver & conductanceIn, std::vector<double> capacitanceIn);
+
+	~ThermalModeSolver();
+
+	// Slowest modeCount modes, slowest first. Modes are normalized so that v.C.v = 1.
+	// Returns the number of modes that converged, which may be fewer than requested; modes that did not converge
+	// are left out, see getUnconvergedCount(). Returns -1 if a steady-state solve inside the iteration failed.
+	int solve(int modeCount, std::vector<double> & timeConstants, std::vector<std::vector<double> > & modes);
+
+	// Lanczos steps taken by the last solve()
+	int getStepCount();
+
+	// Requested modes left out of the last solve()'s results, including any beyond the model's reachable modes
+	int getUnconvergedCount();
+
+private:
+
+	bool applyOperator(const std::vector<double> & in, std::vector<double> & out);
+
+	static void tridiagonalEigen(std::vector<double> & diagonal,
+								 std::vector<double> offDiagonal,
+								 std::vector<std::vector<double> > & eigenvectors);
+
+	SteadyStateSolver & conductance;
+	std::vector<double> capacitanceRoot;	// C^1/2, applied on both sides of G^-1
+
+	int stepCount;
+	int unconvergedCount;
+};
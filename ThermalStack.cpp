@@ -13,17 +13,43 @@
 //		myThermalCircuit.solve();
 
 #include "ThermalStack.h"
+#include "SampleReporter.h"
 #include <iostream>
 #include <math.h>
 #include <iomanip>
 #include <ctime>
 #include <cstdlib>
+#include <chrono>
+#include <algorithm>
+#include <thread>
+#include <sstream>
+#include <limits>
+#include <stdexcept>
+
+// One row's worth of a block footprint in the element grid, inclusive on both ends
+struct FootprintSpan {
+	int xStart;
+	int xEnd;
+	int block;
+
+	bool operator<(const FootprintSpan & other) const { return xStart < other.xStart; }
+};
+
+// Default progress output, overwrites a single console line at each sample point
+static void printProgressLine(const SolveProgress & progress)
+{
+	std::cout << "                                                                                                           \r";
+	std::cout << "    t = " << progress.time << " seconds     T_avg = " << progress.monitoredTemperature << " C"
+		<< "\tdT/dt_Current = " << progress.dTdt << " C/sec\r";
+	std::cout.flush();
+}
 
 ThermalStack::ThermalStack(double meshSizeIn,
 						   double timeStepIn,
 						   int sampleIntervalStepsIn,
 						   double deltaTConvergenceThresholdIn,
-						   double startingTemperatureIn) {
+						   double startingTemperatureIn)
+	: nullConsole(nullptr) {
 	meshSize = meshSizeIn;
 	timeStep = timeStepIn;
 	sampleIntervalSteps = sampleIntervalStepsIn;
@@ -40,355 +66,2118 @@ ThermalStack::ThermalStack(double meshSizeIn,
 	totalElementCount = 0;
 
 	blockIndex = 0;
+	traceEndTime = 0;
+	conductanceTolerance = 0.1;
+
+	hBottom = 0;
+	ambientBottom = startingTemperature;
+	hTop = 0;
+	ambientTop = startingTemperature;
+	hSides = 0;
+	ambientSides = startingTemperature;
+
+	elementArray = nullptr;
+
+	decomposition = nullptr;
+	zOwnedBegin = 0;
+	zOwnedEnd = 0;
+	zAllocBegin = 0;
+	zAllocEnd = 0;
+	console = &std::cout;
+	quiet = false;
+
+	instrumentation = nullptr;
+	resultCache = nullptr;
+	progressCallback = printProgressLine;
+	progressMinIntervalSeconds = 0;
 }
 
 ThermalStack::~ThermalStack()
 {
 	delete [] elementArray;
+	delete instrumentation;
+	delete resultCache;
 }
 
 // Creates a new, user-defined, rectangular material mass -- and pushes it onto one end of the thermal stack.
 // Works like stack::push()
 void ThermalStack::addBlock(double xIn, double yIn, double zIn, Material materialIn, double qGenBlockIn)
 {
-	blocks.push_back(Block(xIn, yIn, zIn, meshSize, materialIn, qGenBlockIn));
+	addBlock(xIn, yIn, zIn, 0, 0, materialIn, qGenBlockIn);
 }
 
-// Generates a 3D model in which material masses are divided into discreet, cubic/rectangular elements.
-// Prepares a linear datastructure for calculating heat transfer physics.
-void ThermalStack::mesh()
+// As above, with the block centre offset from the stack centreline
+void ThermalStack::addBlock(double xIn, double yIn, double zIn, double xOffsetIn, double yOffsetIn, Material materialIn, double qGenBlockIn)
 {
-	initElementArray();
-	genMeshElements();
-	genMeshNodes();
+	blocks.push_back(Block(xIn, yIn, zIn, meshSize, materialIn, qGenBlockIn));
+	blocks.back().place(layerBlocks.size(), xOffsetIn, yOffsetIn);
 
-	int numBlockElementsVector = 0;
-	int numBlockElementsXYZ = 0;
+	layerBlocks.push_back(std::vector<int>(1, blocks.size() - 1));
+	interfaceResistances.push_back(0);
+}
 
-	for (int i = 0; i < blocks.size(); i++) {
-		numBlockElementsVector += blocks[i].getElementVectorCount();
-		numBlockElementsXYZ += blocks[i].getXElementCount() * blocks[i].getYElementCount() * blocks[i].getZElementCount();
+// Adds a block next to the others in the top layer, sharing the layer's thickness
+void ThermalStack::addBlockToLayer(double xIn, double yIn, double xOffsetIn, double yOffsetIn, Material materialIn, double qGenBlockIn)
+{
+	if (layerBlocks.empty()) {
+		*console << "Block ignored, start a layer with addBlock() first" << std::endl;
+		return;
 	}
+
+	double layerThickness = blocks[layerBlocks.back()[0]].getZLength();
+
+	blocks.push_back(Block(xIn, yIn, layerThickness, meshSize, materialIn, qGenBlockIn));
+	blocks.back().place(layerBlocks.size() - 1, xOffsetIn, yOffsetIn);
+
+	layerBlocks.back().push_back(blocks.size() - 1);
 }
 
-// Establishes 3D array dimensions that envelope all blocks
-// The 3D object is stored in a flat array, necessitating the function "nav3DArray"
-void ThermalStack::initElementArray()
+// Attaches a streamed power trace to an existing block
+void ThermalStack::setBlockPowerTrace(int blockIndexIn, std::string tracePathIn)
 {
-	for (unsigned int i = 0; i < blocks.size(); i++) {
+	std::shared_ptr<PowerTrace> trace(new PowerTrace(tracePathIn));
 
-		if (this->xElementCountMax < blocks[i].getXElementCount()) {
-			this->xElementCountMax = blocks[i].getXElementCount();
-		}
+	if (!trace->isOpen()) {
+		*console << "Power trace " << tracePathIn << " could not be read, block " << blockIndexIn << " keeps constant power" << std::endl;
+		return;
+	}
 
-		if (this->yElementCountMax < blocks[i].getYElementCount()) {
-			this->yElementCountMax = blocks[i].getYElementCount();
-		}
+	blocks[blockIndexIn].setPowerTrace(trace);
 
-		this->zElementCountMax += blocks[i].getZElementCount();
+	if (std::find(tracedBlocks.begin(), tracedBlocks.end(), blockIndexIn) == tracedBlocks.end()) {
+		tracedBlocks.push_back(blockIndexIn);
 	}
 
-	unsigned int flat3DArraySize = this->xElementCountMax * this->yElementCountMax * this->zElementCountMax;
-	elementArray = new MeshElement[flat3DArraySize];
+	traceEndTime = std::max(traceEndTime, trace->getEndTime());
+}
 
-	totalElementCount = xElementCountMax * yElementCountMax * zElementCountMax;
+// Swaps a block's material, keeping its geometry and the current temperature field
+void ThermalStack::setBlockMaterial(int blockIndexIn, Material materialIn)
+{
+	blocks[blockIndexIn].setMaterial(materialIn);
+	refreshBlock(blockIndexIn);
 }
 
-// Accesses the 3D object/array and returns a pointer to an element object
-// Returns nullptr if the coordinate does not hold an active element
-MeshElement * ThermalStack::nav3DArray(int x, int y, int z)
+Material ThermalStack::getBlockMaterial(int blockIndexIn)
 {
-	if (x < 0 || x >= xElementCountMax ||
-		y < 0 || y >= yElementCountMax || 
-		z < 0 || z >= zElementCountMax) {
+	return blocks[blockIndexIn].getMaterial();
+}
 
-		return nullptr;
+// Sets a constant heat gen, replacing any power trace
+void ThermalStack::setBlockPower(int blockIndexIn, double qGenBlockIn)
+{
+	blocks[blockIndexIn].setQGen(qGenBlockIn);
+
+	std::vector<int>::iterator traced = std::find(tracedBlocks.begin(), tracedBlocks.end(), blockIndexIn);
+	if (traced != tracedBlocks.end()) {
+		tracedBlocks.erase(traced);
+
+		traceEndTime = 0;
+		for (int i = 0; i < tracedBlocks.size(); i++) {
+			traceEndTime = std::max(traceEndTime, blocks[tracedBlocks[i]].getPowerTraceEndTime());
+		}
 	}
 
-	MeshElement * elementPtr;
-	elementPtr = &elementArray[x + (y * xElementCountMax) + (z * xElementCountMax * yElementCountMax)];
+	refreshBlock(blockIndexIn);
+}
 
-	if (elementPtr->isEmpty()) {
-		return nullptr;
+// Changes the thickness of the block's layer; only a change in the layer's element count forces a re-mesh
+void ThermalStack::setBlockThickness(int blockIndexIn, double zIn)
+{
+	int layer = blocks[blockIndexIn].getLayerIndex();
+	std::vector<int> oldLayerZElementCounts = getLayerZElementCounts();
+
+	for (int i = 0; i < layerBlocks[layer].size(); i++) {
+		blocks[layerBlocks[layer][i]].setZLength(zIn, meshSize);
+	}
+
+	if (elementArray != nullptr && blocks[blockIndexIn].getZElementCount() != oldLayerZElementCounts[layer]) {
+		remeshKeepingTemperatures(oldLayerZElementCounts);
+		return;
+	}
+
+	for (int i = 0; i < layerBlocks[layer].size(); i++) {
+		refreshBlock(layerBlocks[layer][i]);
 	}
-	
-	return elementPtr;
 }
 
-// Converts the block stackup into their associated elements in the 3D array
-// The material masses are centered on eachother
-void ThermalStack::genMeshElements()
+// Recomputes one block's element properties and, once meshed, the links and boundaries that touch it
+void ThermalStack::refreshBlock(int blockIndexIn)
 {
-	std::cout << "Generating mesh elements... ";
+	Block & block = blocks[blockIndexIn];
+	block.calcElementProperties();
 
-	int currBlock = 0;
-	int currBlockRemainingLayers = blocks[currBlock].getZElementCount();
+	if (elementArray == nullptr) {
+		return;
+	}
 
-	for (int z = 0; z < zElementCountMax; z++) {
-		for (int x = 0; x < xElementCountMax; x++) {
-			for (int y = 0; y < yElementCountMax; y++) {
+	block.updateMyElements();
 
-				// create material elements for this layer/block
-				MeshElement * elementPtr = nav3DArray(x, y, z);
-				*elementPtr = MeshElement(startingTemperature,
-										  blocks[currBlock].getQGenElement() * timeStep,
-										  blocks[currBlock].getCElement(),
-										  blocks[currBlock].getXYRAbsolute(),
-										  blocks[currBlock].getZRAbsolute(),
-										  z);
-
-				// if coordinate not in centered block domain, set as empty/inactive
-				// otherwise, record as an active element
-				int xStart = (xElementCountMax - blocks[currBlock].getXElementCount()) / 2;
-				int yStart = (yElementCountMax - blocks[currBlock].getYElementCount()) / 2;
-				int xEnd = xStart + blocks[currBlock].getXElementCount() - 1;
-				int yEnd = yStart + blocks[currBlock].getYElementCount() - 1;
-
-				if (x < xStart	|| 
-					x > xEnd	|| 
-					y < yStart	|| 
-					y > yEnd) {
-					elementPtr->makeEmpty();
-				}
-				else {
-					blocks[currBlock].rememberMyElement(elementPtr);
-					activeElementCount++;
-				}
-			}
-		}
+	for (int i = 0; i < blockNodeIndices[blockIndexIn].size(); i++) {
+		nodeVector[blockNodeIndices[blockIndexIn][i]].calcResistance();
+	}
 
-		currBlockRemainingLayers--;
-		if (currBlockRemainingLayers == 0) {
-			currBlock++;
-			if (currBlock < blocks.size()) {
-				currBlockRemainingLayers = blocks[currBlock].getZElementCount();
-			}
+	for (int i = 0; i < blockBoundaryIndices[blockIndexIn].size(); i++) {
+		MeshBoundary & boundary = boundaryVector[blockBoundaryIndices[blockIndexIn][i]];
+		if (boundary.isSideFace()) {
+			boundary.setGeometry(block.getXYRAbsolute(), block.getElementSideArea());
+		}
+		else {
+			boundary.setGeometry(block.getZRAbsolute(), block.getElementFaceArea());
 		}
+	}
+
+	// the block's elements are back at reference conductances, and its material may have gained or lost a k(T) table
+	trackTemperatureDependence(blockIndexIn);
+}
 
+void ThermalStack::releaseMesh()
+{
+	delete [] elementArray;
+	elementArray = nullptr;
+	nodeVector.clear();
+	boundaryVector.clear();
+	for (int i = 0; i < blocks.size(); i++) {
+		blocks[i].forgetMyElements();
+		blocks[i].calcElementProperties();
 	}
+	xElementCountMax = 0;
+	yElementCountMax = 0;
+	zElementCountMax = 0;
+	activeElementCount = 0;
+	totalElementCount = 0;
+}
 
-	std::cout << "Generated " << activeElementCount << " elements" << std::endl;
+std::vector<int> ThermalStack::getLayerZElementCounts()
+{
+	std::vector<int> layerZElementCounts;
+	for (int i = 0; i < layerBlocks.size(); i++) {
+		layerZElementCounts.push_back(blocks[layerBlocks[i][0]].getZElementCount());
+	}
+	return layerZElementCounts;
 }
 
-// Finds all active elements that are adjacent to this coordinate
-std::vector<MeshElement *> ThermalStack::findNeighborElements(int x, int y, int z)
+// Rebuilds the mesh after a layer gained or lost element layers, then maps the old temperature field onto it.
+// Layers keep their own temperatures; the edited layer's are stretched or squeezed to its new element count.
+void ThermalStack::remeshKeepingTemperatures(std::vector<int> oldLayerZElementCounts)
 {
-	std::vector<MeshElement *> neighbors;
-	MeshElement * tempPtr;
+	int layerSize = xElementCountMax * yElementCountMax;
+	int oldAllocBegin = zAllocBegin;
+	int oldAllocEnd = zAllocEnd;
 
-	int neighborCount = 0;
+	std::vector<double> oldTemperatures(totalElementCount);
+	for (int i = 0; i < totalElementCount; i++) {
+		oldTemperatures[i] = elementArray[i].getTemperature();
+	}
 
-	tempPtr = nav3DArray(x + 1, y, z);
-	if (tempPtr != nullptr) {
-		neighbors.push_back(tempPtr);
-		neighborCount++;
+	std::vector<int> oldLayerZStarts(layerBlocks.size(), 0);
+	for (int i = 1; i < layerBlocks.size(); i++) {
+		oldLayerZStarts[i] = oldLayerZStarts[i - 1] + oldLayerZElementCounts[i - 1];
 	}
 
-	tempPtr = nav3DArray(x - 1, y, z);
-	if (tempPtr != nullptr) {
-		neighbors.push_back(tempPtr);
-		neighborCount++;
+	releaseMesh();
+	mesh();
+
+	std::vector<int> newLayerZElementCounts = getLayerZElementCounts();
+	std::vector<int> newLayerZStarts(layerBlocks.size(), 0);
+	for (int i = 1; i < layerBlocks.size(); i++) {
+		newLayerZStarts[i] = newLayerZStarts[i - 1] + newLayerZElementCounts[i - 1];
 	}
 
-	tempPtr = nav3DArray(x, y + 1, z);
-	if (tempPtr != nullptr) {
-		neighbors.push_back(tempPtr);
-		neighborCount++;
+	for (int z = zAllocBegin; z < zAllocEnd; z++) {
+
+		int layer = zLayerIndices[z];
+		int zWithinLayer = z - newLayerZStarts[layer];
+		int zOld = oldLayerZStarts[layer] + (zWithinLayer * oldLayerZElementCounts[layer]) / newLayerZElementCounts[layer];
+
+		if (zOld < oldAllocBegin || zOld >= oldAllocEnd) {
+			continue;
+		}
+
+		MeshElement * newRow = &elementArray[(z - zAllocBegin) * layerSize];
+		double * oldRow = &oldTemperatures[(zOld - oldAllocBegin) * layerSize];
+		for (int i = 0; i < layerSize; i++) {
+			newRow[i].setTemperature(oldRow[i]);
+		}
 	}
+}
 
-	tempPtr = nav3DArray(x, y - 1, z);
-	if (tempPtr != nullptr) {
-		neighbors.push_back(tempPtr);
-		neighborCount++;
+void ThermalStack::setConductanceTolerance(double toleranceIn)
+{
+	conductanceTolerance = toleranceIn;
+}
+
+// Starts the k(T) bookkeeping over for a new mesh; every k(T) element starts due for a refresh
+void ThermalStack::indexTemperatureDependentConductances()
+{
+	temperatureDependentBlocks.clear();
+	conductanceTemperatures.clear();
+	elementRefreshed.clear();
+
+	for (int i = 0; i < blocks.size(); i++) {
+		trackTemperatureDependence(i);
 	}
+}
 
-	tempPtr = nav3DArray(x, y, z + 1);
-	if (tempPtr != nullptr) {
-		neighbors.push_back(tempPtr);
-		neighborCount++;
+// Adds or drops one block from the k(T) refresh list and marks its elements due for a refresh.
+// Costs only that block's elements, apart from sizing the per-element records when the first k(T) block appears.
+void ThermalStack::trackTemperatureDependence(int blockIndexIn)
+{
+	std::vector<int>::iterator tracked = std::find(temperatureDependentBlocks.begin(), temperatureDependentBlocks.end(), blockIndexIn);
+
+	if (!blocks[blockIndexIn].isTemperatureDependent()) {
+		if (tracked != temperatureDependentBlocks.end()) {
+			temperatureDependentBlocks.erase(tracked);
+		}
+		return;
 	}
 
-	tempPtr = nav3DArray(x, y, z - 1);
-	if (tempPtr != nullptr) {
-		neighbors.push_back(tempPtr);
-		neighborCount++;
+	if (tracked == temperatureDependentBlocks.end()) {
+		temperatureDependentBlocks.push_back(blockIndexIn);
 	}
 
-	//std::cout << "neighborCount " << neighborCount << std::endl;
-	return neighbors;
+	if (conductanceTemperatures.empty()) {
+		conductanceTemperatures.assign(totalElementCount, std::numeric_limits<double>::quiet_NaN());
+		elementRefreshed.assign(totalElementCount, 0);
+	}
+
+	const std::vector<int> & elementIndices = blockElementIndices[blockIndexIn];
+	for (int i = 0; i < elementIndices.size(); i++) {
+		conductanceTemperatures[elementIndices[i]] = std::numeric_limits<double>::quiet_NaN();
+	}
 }
 
-// Creates element-to-element conduction paths and stores these links in a linear datastructure for ease of processing
-void ThermalStack::genMeshNodes()
+// Rescales the half resistances of every k(T) element that has drifted past the tolerance, then recomputes only the
+// links and boundaries touching one. An assembled steady system, if given, is patched to match.
+// Returns the number of elements refreshed.
+int ThermalStack::refreshConductances(SteadyStateSolver * system)
 {
-	std::cout << "Creating element links/nodes... ";
+	int refreshedCount = 0;
 
-	MeshElement * currElementPtr;
+	for (int b = 0; b < temperatureDependentBlocks.size(); b++) {
 
-	for (int z = 0; z < zElementCountMax; z++) {
-		for (int x = 0; x < xElementCountMax; x++) {
-			for (int y = 0; y < yElementCountMax; y++) {
+		Block & block = blocks[temperatureDependentBlocks[b]];
+		const std::vector<int> & elementIndices = blockElementIndices[temperatureDependentBlocks[b]];
 
-				currElementPtr = nav3DArray(x, y, z);
+		for (int i = 0; i < elementIndices.size(); i++) {
 
-				if (currElementPtr != nullptr) {
-					std::vector<MeshElement *> currNeighbors;
-					currNeighbors = findNeighborElements(x, y, z);
+			MeshElement & element = elementArray[elementIndices[i]];
+			double temperature = element.getTemperature();
 
-					for (int i = 0; i < currNeighbors.size(); i++) {
-						if (currNeighbors[i]->checkForExistingNode(currElementPtr) == false) {
-							nodeVector.push_back(MeshNode(currElementPtr, currNeighbors[i]));
-						}
-					}
+			// NaN, before the first refresh, never counts as within tolerance
+			if (fabs(temperature - conductanceTemperatures[elementIndices[i]]) <= conductanceTolerance) {
+				continue;
+			}
+
+			double scale = block.getK() / block.getKAt(temperature);
+			element.setThermalProperties(block.getCElement(), block.getXYRAbsolute() * scale, block.getZRAbsolute() * scale);
+
+			conductanceTemperatures[elementIndices[i]] = temperature;
+			elementRefreshed[elementIndices[i]] = 1;
+			refreshedCount++;
+		}
+	}
+
+	if (refreshedCount == 0) {
+		return 0;
+	}
+
+	// a link between two k(T) blocks is listed under both and simply recomputed twice
+	for (int b = 0; b < temperatureDependentBlocks.size(); b++) {
+
+		const std::vector<int> & nodeIndices = blockNodeIndices[temperatureDependentBlocks[b]];
+
+		for (int i = 0; i < nodeIndices.size(); i++) {
+			MeshNode & node = nodeVector[nodeIndices[i]];
+			if (elementRefreshed[node.getFirst() - elementArray] || elementRefreshed[node.getSecond() - elementArray]) {
+				node.calcResistance();
+				if (system != nullptr) {
+					system->setLinkConductance(nodeIndices[i], 1 / node.getResistanceAbsolute());
 				}
 			}
 		}
+
+		const std::vector<int> & boundaryIndices = blockBoundaryIndices[temperatureDependentBlocks[b]];
+
+		for (int i = 0; i < boundaryIndices.size(); i++) {
+			MeshBoundary & boundary = boundaryVector[boundaryIndices[i]];
+			if (elementRefreshed[boundary.getElement() - elementArray]) {
+				boundary.calcResistance();
+				if (system != nullptr) {
+					system->setBoundaryConductance(boundaryIndices[i], 1 / boundary.getResistanceAbsolute());
+				}
+			}
+		}
+	}
+
+	for (int b = 0; b < temperatureDependentBlocks.size(); b++) {
+		const std::vector<int> & elementIndices = blockElementIndices[temperatureDependentBlocks[b]];
+		for (int i = 0; i < elementIndices.size(); i++) {
+			elementRefreshed[elementIndices[i]] = 0;
+		}
 	}
 
-	std::cout << "Created " << nodeVector.size() << " nodes" << std::endl;
+	return refreshedCount;
 }
 
-// Establishes which block/material mass will be monitored for convergence
-void ThermalStack::monitorBlock(int blockIndexIn)
+// Adds an unmeshed contact resistance on top of the most recently added layer
+void ThermalStack::addInterface(double resistanceArealIn)
 {
-	blockIndex = blockIndexIn;
+	if (layerBlocks.empty()) {
+		*console << "Interface ignored, add the block beneath it first" << std::endl;
+		return;
+	}
+
+	interfaceResistances.back() += resistanceArealIn;
 }
 
-// Outputs a 2D visual of the thermal stack with useful data for each layer
-void ThermalStack::illustrate()
+// Thin material layers such as TIMs and bond lines reduce to R = thickness / k
+void ThermalStack::addInterface(Material materialIn, double thicknessIn)
 {
-	std::cout << std::fixed;
-	std::cout << std::setprecision(0);
+	addInterface(thicknessIn / materialIn.k);
+}
 
-	std::cout << "                                         Matl        T_avg      T_var     Q_gen     Vol \n\n";
+// Convection off the bottom face of the first block
+void ThermalStack::setConvectionBottom(double hIn, double ambientTemperatureIn)
+{
+	hBottom = hIn;
+	ambientBottom = ambientTemperatureIn;
+}
 
-	for (int i = 0; i < blocks.size(); i++) {
+// Convection off the top face of the last block
+void ThermalStack::setConvectionTop(double hIn, double ambientTemperatureIn)
+{
+	hTop = hIn;
+	ambientTop = ambientTemperatureIn;
+}
 
-		double doublefiedElementCount = blocks[i].getXElementCount();
-		double normalizedX = doublefiedElementCount / xElementCountMax;
-		int dashCount = round(normalizedX * 10) * 2; // max is 20
-		int dashStartIndex = (20 - dashCount) / 2;
-		int dashEndIndex = 20 - ((20 - dashCount) / 2);
+// Convection off every exposed side face
+void ThermalStack::setConvectionSides(double hIn, double ambientTemperatureIn)
+{
+	hSides = hIn;
+	ambientSides = ambientTemperatureIn;
+}
 
-		std::cout << "    Block " << i << "\t";
-		for (int j = 0; j < 20; j++) {
-			if (j >= dashStartIndex && j < dashEndIndex) {
-				std::cout << "-";
-			}
-			else {
-				std::cout << " ";
-			}
-		}
-		std::cout << "  \t " << blocks[i].getMaterialName() << "  "
-				  << "  " << blocks[i].getBulkTemp() << " C"
-				  << "\t" << blocks[i].getTempNonUniformity() << " C"
-			      << "\t  " << blocks[i].getQGen() << " W"
-				  << "\t    " << blocks[i].getVolume() << " mm^3";
-		std::cout << "\n";
+// Hands the z-layers out across processes; the actual split happens in initElementArray()
+void ThermalStack::decompose(DomainDecomposition * decompositionIn)
+{
+	decomposition = decompositionIn;
+
+	if (decomposition->getRank() != 0) {
+		console = &nullConsole;
 	}
 }
 
-// Upon reaching a steady-state solution, this method crawls historical data and locates the instance at t = 1 * time constant
-int ThermalStack::locateTauStep(double tempInitial, double tempSteady)
+void ThermalStack::setQuiet(bool quietIn)
 {
-	double dTTotal = tempSteady - tempInitial;
-	double dTAtTauOne = dTTotal * 0.368;
-	int tauStep = 0;
+	quiet = quietIn;
 
-	for (int i = 0; i < tempHistory.size(); i++) {
-		tauStep++;
-		if ((tempSteady - tempHistory[i]) < dTAtTauOne) {
-			break;
-		}
+	if (quiet || !isFirstProcess()) {
+		console = &nullConsole;
+	}
+	else {
+		console = &std::cout;
 	}
 
-	return tauStep;
+	if (quiet) {
+		progressCallback = ProgressCallback();
+	}
+	else if (!progressCallback) {
+		progressCallback = printProgressLine;
+	}
 }
 
-// Marches the solution to convergence, outputs data realtime, outputs report after converging
-void ThermalStack::solve() 
+// Generates a 3D model in which material masses are divided into discreet, cubic/rectangular elements.
+// Prepares a linear datastructure for calculating heat transfer physics.
+void ThermalStack::mesh()
 {
+	// meshing again starts over, as if from a freshly built stack
+	if (elementArray != nullptr) {
+		releaseMesh();
+		for (int i = 0; i < tracedBlocks.size(); i++) {
+			blocks[tracedBlocks[i]].rewindPowerTrace();
+		}
+		currTime = timeStep;
+	}
 
-	clock_t startTime = clock(); //Start timer
-
-	std::cout << "\nThermal stack initial state:\n\n";
-	illustrate();
-	std::cout << "\n";
+	if (instrumentation != nullptr) instrumentation->startPhase("initElementArray");
+	initElementArray();
+	if (instrumentation != nullptr) instrumentation->stopPhase("initElementArray");
 
-	std::cout << std::fixed;
-	std::cout << std::setprecision(0);
+	if (instrumentation != nullptr) instrumentation->startPhase("genMeshElements");
+	genMeshElements();
+	if (instrumentation != nullptr) instrumentation->stopPhase("genMeshElements");
 
-	std::cout << "Solving...\n\n";
-	std::cout << "    Monitoring block " << blockIndex << ", " << blocks[blockIndex].getMaterialName()
-		<< ", generating " << blocks[blockIndex].getQGen() << " W\n";
+	if (instrumentation != nullptr) instrumentation->startPhase("genMeshNodes");
+	genMeshNodes();
+	if (instrumentation != nullptr) instrumentation->stopPhase("genMeshNodes");
 
-	std::cout << std::setprecision(2);
-	std::cout << "    Mesh Size = " << meshSize << " mm\n";
-	std::cout << std::setprecision(6);
-	std::cout << "    Time Step = " << timeStep << " sec\n";
-	std::cout << "    Sampling Time Inverval = " << timeStep * sampleIntervalSteps << " sec\n";
-	std::cout << std::setprecision(3);
-	std::cout << "    Convergence dT/dt_Target = " << deltaTConvergenceThreshold / (timeStep * sampleIntervalSteps) << " C/sec\n\n";
-	std::cout << "    t = " << 0 << " seconds         T_avg = " << startingTemperature << " C\n";
+	if (instrumentation != nullptr) instrumentation->startPhase("genMeshBoundaries");
+	genMeshBoundaries();
+	if (instrumentation != nullptr) instrumentation->stopPhase("genMeshBoundaries");
 
-	bool haveIConvergedYet = false;
-	int currStep = 0;
-	int tauInterval = 0;
-	double currMonitoredTemperature = 0;
+	indexTemperatureDependentConductances();
 
-	while (haveIConvergedYet == false) {
+	if (instrumentation != nullptr) {
+		recordMeshFootprint();
+	}
 
-		for (int i = 0; i < nodeVector.size(); i++) { 
-			nodeVector[i].calcEnergyTransfer(timeStep);
-		}
+	int numBlockElementsVector = 0;
+	int numBlockElementsXYZ = 0;
 
-		for (int j = 0; j < totalElementCount; j++) {
-			elementArray[j].applyEnergyTransfer();
-		}
+	for (int i = 0; i < blocks.size(); i++) {
+		numBlockElementsVector += blocks[i].getElementVectorCount();
+		numBlockElementsXYZ += blocks[i].getXElementCount() * blocks[i].getYElementCount() * blocks[i].getZElementCount();
+	}
+}
 
-		currTime += timeStep;
-		currStep = currTime / timeStep;
+bool ThermalStack::isMeshed()
+{
+	return elementArray != nullptr;
+}
 
-		if (currStep % sampleIntervalSteps == 0) {
+// Establishes 3D array dimensions that envelope all blocks, and where each block's footprint sits in them
+// The 3D object is stored in a flat array, necessitating the function "nav3DArray"
+void ThermalStack::initElementArray()
+{
+	// footprint extents in half-element units, so that centred blocks of odd and even widths share one grid
+	int xLow = 0;
+	int xHigh = 0;
+	int yLow = 0;
+	int yHigh = 0;
 
-			currMonitoredTemperature = blocks[blockIndex].getBulkTemp();
-			tempHistory.push_back(currMonitoredTemperature);
+	for (unsigned int i = 0; i < blocks.size(); i++) {
 
-			if ((currMonitoredTemperature - previousTemperature) > deltaTConvergenceThreshold) {
-				std::cout << "                                                                                                           \r";
-				std::cout << "    t = " << currTime << " seconds     T_avg = " << currMonitoredTemperature << " C"
-					<< "\tdT/dt_Current = " << (currMonitoredTemperature - previousTemperature) / (timeStep * sampleIntervalSteps) << " C/sec\r";
-				std::cout.flush();
-			}
-			else {
+		int xCentre = round(2 * blocks[i].getXOffset() / meshSize);
+		int yCentre = round(2 * blocks[i].getYOffset() / meshSize);
 
-				tauInterval = locateTauStep(startingTemperature, currMonitoredTemperature);
-				double tauTime = tauInterval * sampleIntervalSteps * timeStep;
-				std::cout << "                                                                                                           \r";
-				std::cout << "    t = " << tauTime << " seconds     T_avg = " << tempHistory[tauInterval] << " C"
-					<< "  \t<- @ one time constant\n";
-				std::cout << "    t = " << currTime << " seconds     T_avg = " << currMonitoredTemperature << " C"
-					<< "  \t<- @ steady state\n";
+		int blockXLow = xCentre - blocks[i].getXElementCount();
+		int blockXHigh = xCentre + blocks[i].getXElementCount();
+		int blockYLow = yCentre - blocks[i].getYElementCount();
+		int blockYHigh = yCentre + blocks[i].getYElementCount();
 
-				int secondsElapsed = (clock() - startTime) / CLOCKS_PER_SEC;
-				int minutesElapsed = floor(secondsElapsed / 60);
-				int secondsRemainder = secondsElapsed % 60;
-				
-				std::cout << "\nConverged on the following solution after " 
-					<< minutesElapsed << " minutes and "  << secondsRemainder << " seconds";
-				haveIConvergedYet = true;
-			}
-			previousTemperature = currMonitoredTemperature;
-		}
+		if (i == 0 || blockXLow < xLow) xLow = blockXLow;
+		if (i == 0 || blockXHigh > xHigh) xHigh = blockXHigh;
+		if (i == 0 || blockYLow < yLow) yLow = blockYLow;
+		if (i == 0 || blockYHigh > yHigh) yHigh = blockYHigh;
 	}
 
-	std::cout << "\n\n";
-	illustrate();
-	std::cout << "\n";
+	this->xElementCountMax = (xHigh - xLow + 1) / 2;
+	this->yElementCountMax = (yHigh - yLow + 1) / 2;
+
+	for (unsigned int i = 0; i < blocks.size(); i++) {
 
-	double thermalImpedance = (currMonitoredTemperature - startingTemperature) / blocks[blockIndex].getQGen();
+		int xCentre = round(2 * blocks[i].getXOffset() / meshSize);
+		int yCentre = round(2 * blocks[i].getYOffset() / meshSize);
 
-	std::cout << std::fixed;
-	std::cout << std::setprecision(3);
-	std::cout << "Thermal impedance, heat source to infinite heatsink = " << thermalImpedance << " K/W \n\n";
-}
\ No newline at end of file
+		blocks[i].setElementOrigin((xCentre - blocks[i].getXElementCount() - xLow) / 2,
+								   (yCentre - blocks[i].getYElementCount() - yLow) / 2);
+	}
+
+	int zElementCount = 0;
+	for (unsigned int i = 0; i < layerBlocks.size(); i++) {
+		zElementCount += blocks[layerBlocks[i][0]].getZElementCount();
+	}
+
+	// a process without a layer of its own has nothing to step or exchange, so every process refuses alike
+	if (decomposition != nullptr && decomposition->getRankCount() > zElementCount) {
+		std::ostringstream message;
+		message << decomposition->getRankCount() << " processes for only " << zElementCount
+				<< " z-layers, use fewer processes or a finer mesh";
+		*console << "Error: " << message.str() << std::endl;
+		throw std::runtime_error(message.str());
+	}
+
+	this->zElementCountMax = zElementCount;
+
+	// each process owns a contiguous, near-equal share of the z-layers
+	zOwnedBegin = 0;
+	zOwnedEnd = zElementCountMax;
+
+	if (decomposition != nullptr) {
+		int rankCount = decomposition->getRankCount();
+		int rank = decomposition->getRank();
+
+		int baseLayers = zElementCountMax / rankCount;
+		int extraLayers = zElementCountMax % rankCount;
+		zOwnedBegin = rank * baseLayers + std::min(rank, extraLayers);
+		zOwnedEnd = zOwnedBegin + baseLayers + (rank < extraLayers ? 1 : 0);
+	}
+
+	zAllocBegin = std::max(0, zOwnedBegin - 1);
+	zAllocEnd = std::min(zElementCountMax, zOwnedEnd + 1);
+
+	int layerSize = xElementCountMax * yElementCountMax;
+	haloSendLower.assign(layerSize, 0);
+	haloReceiveLower.assign(layerSize, 0);
+	haloSendUpper.assign(layerSize, 0);
+	haloReceiveUpper.assign(layerSize, 0);
+
+	unsigned int flat3DArraySize = this->xElementCountMax * this->yElementCountMax * (zAllocEnd - zAllocBegin);
+	elementArray = new MeshElement[flat3DArraySize];
+
+	totalElementCount = flat3DArraySize;
+}
+
+// True if this process steps layer z, as opposed to holding it as a halo or not at all
+bool ThermalStack::ownsLayer(int z)
+{
+	return (z >= zOwnedBegin && z < zOwnedEnd);
+}
+
+// Accesses the 3D object/array and returns a pointer to an element object
+// Returns nullptr if the coordinate does not hold an active element
+MeshElement * ThermalStack::nav3DArray(int x, int y, int z)
+{
+	if (x < 0 || x >= xElementCountMax ||
+		y < 0 || y >= yElementCountMax || 
+		z < zAllocBegin || z >= zAllocEnd) {
+
+		return nullptr;
+	}
+
+	MeshElement * elementPtr;
+	elementPtr = &elementArray[x + (y * xElementCountMax) + ((z - zAllocBegin) * xElementCountMax * yElementCountMax)];
+
+	if (elementPtr->isEmpty()) {
+		return nullptr;
+	}
+	
+	return elementPtr;
+}
+
+// Converts the block stackup into their associated elements in the 3D array
+// Each layer is rasterized from its block footprints; coordinates outside every footprint are left empty/inactive
+void ThermalStack::genMeshElements()
+{
+	*console << "Generating mesh elements... ";
+
+	zLayerIndices.assign(zElementCountMax, 0);
+	blockElementIndices.assign(blocks.size(), std::vector<int>());
+
+	int zStart = 0;
+
+	for (int layer = 0; layer < layerBlocks.size(); layer++) {
+		rasterizeLayer(layer, zStart);
+		zStart += blocks[layerBlocks[layer][0]].getZElementCount();
+	}
+
+	*console << "Generated " << (long long)globalSum(activeElementCount) << " elements" << std::endl;
+}
+
+// Fills one layer's z-range of the 3D array
+// Footprints are indexed as sorted x-spans per row of the XY grid, so every coordinate is visited once
+// no matter how many blocks share the layer
+void ThermalStack::rasterizeLayer(int layer, int zStart)
+{
+	std::vector<std::vector<FootprintSpan> > rows(yElementCountMax);
+
+	for (int i = 0; i < layerBlocks[layer].size(); i++) {
+
+		int currBlock = layerBlocks[layer][i];
+		FootprintSpan span;
+		span.xStart = blocks[currBlock].getXElementStart();
+		span.xEnd = span.xStart + blocks[currBlock].getXElementCount() - 1;
+		span.block = currBlock;
+
+		int yStart = blocks[currBlock].getYElementStart();
+		int yEnd = yStart + blocks[currBlock].getYElementCount() - 1;
+
+		for (int y = yStart; y <= yEnd; y++) {
+			rows[y].push_back(span);
+		}
+	}
+
+	// overlapping footprints keep the block added first: spans arrive in insertion order, and each is cut around
+	// the cells earlier blocks have already claimed in its row
+	bool overlapFound = false;
+	std::vector<int> footprintElementCounts(blocks.size(), 0);
+
+	for (int y = 0; y < yElementCountMax; y++) {
+
+		std::vector<FootprintSpan> claimedRow;
+
+		for (int i = 0; i < rows[y].size(); i++) {
+
+			std::vector<FootprintSpan> pieces(1, rows[y][i]);
+
+			for (int j = 0; j < claimedRow.size(); j++) {
+
+				const FootprintSpan & claimed = claimedRow[j];
+				std::vector<FootprintSpan> uncovered;
+
+				for (int p = 0; p < pieces.size(); p++) {
+					if (pieces[p].xEnd < claimed.xStart || pieces[p].xStart > claimed.xEnd) {
+						uncovered.push_back(pieces[p]);
+						continue;
+					}
+
+					overlapFound = true;
+
+					if (pieces[p].xStart < claimed.xStart) {
+						FootprintSpan left = pieces[p];
+						left.xEnd = claimed.xStart - 1;
+						uncovered.push_back(left);
+					}
+					if (pieces[p].xEnd > claimed.xEnd) {
+						FootprintSpan right = pieces[p];
+						right.xStart = claimed.xEnd + 1;
+						uncovered.push_back(right);
+					}
+				}
+				pieces.swap(uncovered);
+			}
+
+			for (int p = 0; p < pieces.size(); p++) {
+				footprintElementCounts[pieces[p].block] += pieces[p].xEnd - pieces[p].xStart + 1;
+			}
+			claimedRow.insert(claimedRow.end(), pieces.begin(), pieces.end());
+		}
+
+		std::sort(claimedRow.begin(), claimedRow.end());
+		rows[y].swap(claimedRow);
+	}
+
+	if (overlapFound) {
+		*console << "\nWarning: block footprints overlap in layer " << layer
+				  << ", overlapping elements are assigned to the block added first"
+				  << " and the others' power is spread over the elements they keep\n";
+	}
+
+	// every process rasterizes every row, so these counts cover the whole layer
+	for (int i = 0; i < layerBlocks[layer].size(); i++) {
+		int currBlock = layerBlocks[layer][i];
+		blocks[currBlock].setFootprintElementCount(footprintElementCounts[currBlock]);
+		blocks[currBlock].calcElementProperties();
+	}
+
+	int zEnd = zStart + blocks[layerBlocks[layer][0]].getZElementCount();
+
+	for (int z = zStart; z < zEnd; z++) {
+		zLayerIndices[z] = layer;
+	}
+
+	// only this process's owned and halo layers are stored
+	for (int z = std::max(zStart, zAllocBegin); z < std::min(zEnd, zAllocEnd); z++) {
+
+		bool owned = ownsLayer(z);
+
+		for (int y = 0; y < yElementCountMax; y++) {
+
+			MeshElement * rowPtr = &elementArray[(y * xElementCountMax) + ((z - zAllocBegin) * xElementCountMax * yElementCountMax)];
+			int x = 0;
+
+			for (int i = 0; i < rows[y].size(); i++) {
+
+				const FootprintSpan & span = rows[y][i];
+				Block & currBlock = blocks[span.block];
+
+				for (; x < span.xStart; x++) {
+					rowPtr[x].makeEmpty();
+				}
+
+				// create material elements for this block
+				for (; x <= span.xEnd; x++) {
+					rowPtr[x] = MeshElement(startingTemperature,
+											currBlock.getCElement(),
+											currBlock.getXYRAbsolute(),
+											currBlock.getZRAbsolute(),
+											z,
+											span.block);
+					blockElementIndices[span.block].push_back(&rowPtr[x] - elementArray);
+					if (owned) {
+						currBlock.rememberMyElement(&rowPtr[x]);
+						activeElementCount++;
+					}
+				}
+			}
+
+			for (; x < xElementCountMax; x++) {
+				rowPtr[x].makeEmpty();
+			}
+		}
+	}
+}
+
+// Finds all active elements that are adjacent to this coordinate
+std::vector<MeshElement *> ThermalStack::findNeighborElements(int x, int y, int z)
+{
+	std::vector<MeshElement *> neighbors;
+	MeshElement * tempPtr;
+
+	int neighborCount = 0;
+
+	tempPtr = nav3DArray(x + 1, y, z);
+	if (tempPtr != nullptr) {
+		neighbors.push_back(tempPtr);
+		neighborCount++;
+	}
+
+	tempPtr = nav3DArray(x - 1, y, z);
+	if (tempPtr != nullptr) {
+		neighbors.push_back(tempPtr);
+		neighborCount++;
+	}
+
+	tempPtr = nav3DArray(x, y + 1, z);
+	if (tempPtr != nullptr) {
+		neighbors.push_back(tempPtr);
+		neighborCount++;
+	}
+
+	tempPtr = nav3DArray(x, y - 1, z);
+	if (tempPtr != nullptr) {
+		neighbors.push_back(tempPtr);
+		neighborCount++;
+	}
+
+	tempPtr = nav3DArray(x, y, z + 1);
+	if (tempPtr != nullptr) {
+		neighbors.push_back(tempPtr);
+		neighborCount++;
+	}
+
+	tempPtr = nav3DArray(x, y, z - 1);
+	if (tempPtr != nullptr) {
+		neighbors.push_back(tempPtr);
+		neighborCount++;
+	}
+
+	//*console << "neighborCount " << neighborCount << std::endl;
+	return neighbors;
+}
+
+// Creates element-to-element conduction paths and stores these links in a linear datastructure for ease of processing
+void ThermalStack::genMeshNodes()
+{
+	*console << "Creating element links/nodes... ";
+
+	MeshElement * currElementPtr;
+
+	// links into a halo are duplicated on the neighbouring process, only the one looking upward counts them
+	int uniqueLinkCount = 0;
+
+	blockNodeIndices.assign(blocks.size(), std::vector<int>());
+
+	for (int z = zOwnedBegin; z < zOwnedEnd; z++) {
+		for (int x = 0; x < xElementCountMax; x++) {
+			for (int y = 0; y < yElementCountMax; y++) {
+
+				currElementPtr = nav3DArray(x, y, z);
+
+				if (currElementPtr != nullptr) {
+					std::vector<MeshElement *> currNeighbors;
+					currNeighbors = findNeighborElements(x, y, z);
+
+					for (int i = 0; i < currNeighbors.size(); i++) {
+						if (currNeighbors[i]->checkForExistingNode(currElementPtr) == false) {
+							nodeVector.push_back(MeshNode(currElementPtr,
+														  currNeighbors[i],
+														  interfaceResistanceBetween(currElementPtr, currNeighbors[i])));
+
+							int firstBlock = currElementPtr->getBlockIndex();
+							int secondBlock = currNeighbors[i]->getBlockIndex();
+							blockNodeIndices[firstBlock].push_back(nodeVector.size() - 1);
+							if (secondBlock != firstBlock) {
+								blockNodeIndices[secondBlock].push_back(nodeVector.size() - 1);
+							}
+
+							if (currNeighbors[i]->getZLayer() >= zOwnedBegin) {
+								uniqueLinkCount++;
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	*console << "Created " << (long long)globalSum(uniqueLinkCount) << " nodes" << std::endl;
+}
+
+// Starts collecting run statistics, reported as JSON to reportPathIn once solve() finishes
+void ThermalStack::enableInstrumentation(std::string reportPathIn)
+{
+	if (instrumentation == nullptr) {
+		instrumentation = new RunInstrumentation();
+	}
+	reportPath = reportPathIn;
+}
+
+void ThermalStack::enableResultCache(std::string directoryIn)
+{
+	delete resultCache;
+	resultCache = new ResultCache(directoryIn);
+}
+
+// Routes per-sample progress to a user callback instead of the console
+void ThermalStack::setProgressCallback(ProgressCallback callbackIn, double minIntervalSecondsIn)
+{
+	progressCallback = callbackIn;
+	progressMinIntervalSeconds = minIntervalSecondsIn;
+}
+
+// Measures the average memory held per active element and per link
+void ThermalStack::recordMeshFootprint()
+{
+	double elementBytes = 0;
+	for (int i = 0; i < totalElementCount; i++) {
+		elementBytes += elementArray[i].getFootprintBytes();
+	}
+
+	double bytesPerElement = 0;
+	if (activeElementCount > 0) {
+		bytesPerElement = elementBytes / activeElementCount;
+	}
+
+	instrumentation->setMeshFootprint(activeElementCount,
+									  totalElementCount,
+									  nodeVector.size(),
+									  bytesPerElement,
+									  sizeof(MeshNode));
+}
+
+// Attaches convective boundaries to the exposed faces of the outermost elements
+void ThermalStack::genMeshBoundaries()
+{
+	blockBoundaryIndices.assign(blocks.size(), std::vector<int>());
+
+	if (hBottom <= 0 && hTop <= 0 && hSides <= 0) {
+		return;
+	}
+
+	*console << "Creating convection boundaries... ";
+
+	MeshElement * currElementPtr;
+
+	for (int z = zOwnedBegin; z < zOwnedEnd; z++) {
+
+		for (int x = 0; x < xElementCountMax; x++) {
+			for (int y = 0; y < yElementCountMax; y++) {
+
+				currElementPtr = nav3DArray(x, y, z);
+
+				if (currElementPtr == nullptr) {
+					continue;
+				}
+
+				Block & currBlock = blocks[currElementPtr->getBlockIndex()];
+				int boundaryCountBefore = boundaryVector.size();
+
+				if (hBottom > 0 && z == 0) {
+					boundaryVector.push_back(MeshBoundary(currElementPtr,
+														  currBlock.getZRAbsolute(),
+														  hBottom,
+														  currBlock.getElementFaceArea(),
+														  ambientBottom,
+														  false));
+				}
+
+				if (hTop > 0 && z == zElementCountMax - 1) {
+					boundaryVector.push_back(MeshBoundary(currElementPtr,
+														  currBlock.getZRAbsolute(),
+														  hTop,
+														  currBlock.getElementFaceArea(),
+														  ambientTop,
+														  false));
+				}
+
+				if (hSides > 0) {
+					int exposedSides = (nav3DArray(x + 1, y, z) == nullptr) +
+									   (nav3DArray(x - 1, y, z) == nullptr) +
+									   (nav3DArray(x, y + 1, z) == nullptr) +
+									   (nav3DArray(x, y - 1, z) == nullptr);
+
+					for (int i = 0; i < exposedSides; i++) {
+						boundaryVector.push_back(MeshBoundary(currElementPtr,
+															  currBlock.getXYRAbsolute(),
+															  hSides,
+															  currBlock.getElementSideArea(),
+															  ambientSides,
+															  true));
+					}
+				}
+
+				for (int i = boundaryCountBefore; i < boundaryVector.size(); i++) {
+					blockBoundaryIndices[currElementPtr->getBlockIndex()].push_back(i);
+				}
+			}
+		}
+	}
+
+	*console << "Created " << (long long)globalSum(boundaryVector.size()) << " boundaries" << std::endl;
+}
+
+// Absolute contact resistance for a link between two elements [K/W]
+// Only z-links that cross from one layer into the next carry an interface; the smaller face area governs
+double ThermalStack::interfaceResistanceBetween(MeshElement * first, MeshElement * second)
+{
+	int firstLayer = zLayerIndices[first->getZLayer()];
+	int secondLayer = zLayerIndices[second->getZLayer()];
+
+	if (firstLayer == secondLayer) {
+		return 0;
+	}
+
+	int lowerLayer = std::min(firstLayer, secondLayer);
+
+	double contactArea = std::min(blocks[first->getBlockIndex()].getElementFaceArea(),
+								  blocks[second->getBlockIndex()].getElementFaceArea());
+
+	return interfaceResistances[lowerLayer] / contactArea;
+}
+
+// Swaps boundary layer temperatures with the neighbouring processes after every time step
+void ThermalStack::exchangeHalos()
+{
+	int layerSize = xElementCountMax * yElementCountMax;
+
+	MeshElement * lowestOwnedLayer = &elementArray[(zOwnedBegin - zAllocBegin) * layerSize];
+	MeshElement * highestOwnedLayer = &elementArray[(zOwnedEnd - 1 - zAllocBegin) * layerSize];
+
+	for (int i = 0; i < layerSize; i++) {
+		haloSendLower[i] = lowestOwnedLayer[i].getTemperature();
+		haloSendUpper[i] = highestOwnedLayer[i].getTemperature();
+	}
+
+	decomposition->exchangeHalo(&haloSendLower[0], &haloReceiveLower[0],
+								&haloSendUpper[0], &haloReceiveUpper[0],
+								layerSize);
+
+	if (zOwnedBegin > zAllocBegin) {
+		MeshElement * lowerHaloLayer = &elementArray[(zOwnedBegin - 1 - zAllocBegin) * layerSize];
+		for (int i = 0; i < layerSize; i++) {
+			lowerHaloLayer[i].setTemperature(haloReceiveLower[i]);
+		}
+	}
+
+	if (zOwnedEnd < zAllocEnd) {
+		MeshElement * upperHaloLayer = &elementArray[(zOwnedEnd - zAllocBegin) * layerSize];
+		for (int i = 0; i < layerSize; i++) {
+			upperHaloLayer[i].setTemperature(haloReceiveUpper[i]);
+		}
+	}
+}
+
+// Console output, progress and reports come from the first process only
+bool ThermalStack::isFirstProcess()
+{
+	return (decomposition == nullptr || decomposition->getRank() == 0);
+}
+
+// Adds up a per-process quantity over all processes
+double ThermalStack::globalSum(double value)
+{
+	if (decomposition != nullptr) {
+		decomposition->sum(&value, 1);
+	}
+	return value;
+}
+
+// Mean temperature of a block, including the elements other processes hold
+double ThermalStack::getGlobalBulkTemp(int blockIndexIn)
+{
+	if (decomposition == nullptr) {
+		return blocks[blockIndexIn].getBulkTemp();
+	}
+
+	double partials[2] = { blocks[blockIndexIn].getTempSum(), (double)blocks[blockIndexIn].getElementVectorCount() };
+	decomposition->sum(partials, 2);
+
+	return partials[0] / partials[1];
+}
+
+// Hottest minus coldest element of a block, including the elements other processes hold
+double ThermalStack::getGlobalTempNonUniformity(int blockIndexIn)
+{
+	if (decomposition == nullptr) {
+		return blocks[blockIndexIn].getTempNonUniformity();
+	}
+
+	double low = blocks[blockIndexIn].getTempMin();
+	double high = blocks[blockIndexIn].getTempMax();
+	decomposition->min(&low, 1);
+	decomposition->max(&high, 1);
+
+	return (high - low);
+}
+
+// Establishes which block/material mass will be monitored for convergence
+void ThermalStack::monitorBlock(int blockIndexIn)
+{
+	blockIndex = blockIndexIn;
+}
+
+// Outputs a 2D visual of the thermal stack with useful data for each layer
+void ThermalStack::illustrate()
+{
+	*console << std::fixed;
+	*console << std::setprecision(0);
+
+	*console << "                                         Matl        T_avg      T_var     Q_gen     Vol \n\n";
+
+	for (int i = 0; i < blocks.size(); i++) {
+
+		double doublefiedElementCount = blocks[i].getXElementCount();
+		double normalizedX = doublefiedElementCount / xElementCountMax;
+		int dashCount = round(normalizedX * 10) * 2; // max is 20
+		int dashStartIndex = (20 - dashCount) / 2;
+		int dashEndIndex = 20 - ((20 - dashCount) / 2);
+
+		// off-centre blocks are drawn where they sit
+		if (blocks[i].getXOffset() != 0) {
+			double xStartFraction = (double)blocks[i].getXElementStart() / xElementCountMax;
+			dashStartIndex = round(xStartFraction * 20);
+			dashEndIndex = round((xStartFraction + normalizedX) * 20);
+		}
+
+		*console << "    Block " << i << "\t";
+		for (int j = 0; j < 20; j++) {
+			if (j >= dashStartIndex && j < dashEndIndex) {
+				*console << "-";
+			}
+			else {
+				*console << " ";
+			}
+		}
+		*console << "  \t " << blocks[i].getMaterialName() << "  "
+				  << "  " << getGlobalBulkTemp(i) << " C"
+				  << "\t" << getGlobalTempNonUniformity(i) << " C"
+			      << "\t  " << blocks[i].getQGen() << " W"
+				  << "\t    " << blocks[i].getVolume() << " mm^3";
+		*console << "\n";
+
+		int layer = blocks[i].getLayerIndex();
+		bool lastInLayer = (layerBlocks[layer].back() == i);
+
+		if (lastInLayer && interfaceResistances[layer] > 0 && layer + 1 < layerBlocks.size()) {
+			*console << std::setprecision(2);
+			*console << "            \t    ~~~~~~~~~~~~  \t Interface   " << interfaceResistances[layer] << " K*mm^2/W\n";
+			*console << std::setprecision(0);
+		}
+	}
+}
+
+// Upon reaching a steady-state solution, this method crawls historical data and locates the instance at t = 1 * time constant
+int ThermalStack::locateTauStep(double tempInitial, double tempSteady)
+{
+	double dTTotal = tempSteady - tempInitial;
+	double dTAtTauOne = dTTotal * 0.368;
+	int tauStep = 0;
+
+	for (int i = 0; i < tempHistory.size(); i++) {
+		tauStep++;
+		if (fabs(tempSteady - tempHistory[i]) < fabs(dTAtTauOne)) {
+			break;
+		}
+	}
+
+	// a warm-started solve may converge within a sample or two
+	return std::min(tauStep, (int)tempHistory.size() - 1);
+}
+
+// One explicit time step: trace updates, link and boundary transfers, then halos from neighbouring processes
+void ThermalStack::advanceOneStep()
+{
+	if (!temperatureDependentBlocks.empty()) {
+		refreshConductances(nullptr);
+	}
+
+	// a trace's power over the step is sampled at its start, currTime running one step ahead
+	for (int i = 0; i < tracedBlocks.size(); i++) {
+		blocks[tracedBlocks[i]].updatePowerFromTrace(currTime - timeStep);
+	}
+
+	blockEnergyGenPerTimestep.resize(blocks.size());
+	for (int i = 0; i < blocks.size(); i++) {
+		blockEnergyGenPerTimestep[i] = blocks[i].getQGenElement() * timeStep;
+	}
+
+	for (int i = 0; i < nodeVector.size(); i++) { 
+		nodeVector[i].calcEnergyTransfer(timeStep);
+	}
+
+	for (int i = 0; i < boundaryVector.size(); i++) {
+		boundaryVector[i].calcEnergyTransfer(timeStep);
+	}
+
+	for (int j = 0; j < totalElementCount; j++) {
+		elementArray[j].applyEnergyTransfer(blockEnergyGenPerTimestep.data());
+	}
+
+	if (decomposition != nullptr) {
+		exchangeHalos();
+	}
+
+	currTime += timeStep;
+}
+
+void ThermalStack::step(int stepCount)
+{
+	if (elementArray == nullptr) {
+		*console << "Nothing to step, call mesh() first" << std::endl;
+		return;
+	}
+
+	for (int i = 0; i < stepCount; i++) {
+		advanceOneStep();
+	}
+}
+
+// currTime runs one step ahead, see the constructor
+double ThermalStack::getTime() { return currTime - timeStep; }
+int ThermalStack::getBlockCount() { return blocks.size(); }
+
+// Collective when decomposed, like the convergence sampling
+BlockStatistics ThermalStack::getBlockStatistics(int blockIndexIn)
+{
+	BlockStatistics statistics;
+	statistics.meanTemperature = getGlobalBulkTemp(blockIndexIn);
+	statistics.minTemperature = blocks[blockIndexIn].getTempMin();
+	statistics.maxTemperature = blocks[blockIndexIn].getTempMax();
+	statistics.qGen = blocks[blockIndexIn].getQGen();
+
+	if (decomposition != nullptr) {
+		decomposition->min(&statistics.minTemperature, 1);
+		decomposition->max(&statistics.maxTemperature, 1);
+	}
+
+	return statistics;
+}
+
+TemperatureField ThermalStack::getTemperatureField()
+{
+	TemperatureField field;
+	field.temperature = nullptr;
+	field.stride = sizeof(MeshElement);
+	field.xCount = 0;
+	field.yCount = 0;
+	field.zCount = 0;
+	field.zBegin = 0;
+
+	if (elementArray == nullptr) {
+		return field;
+	}
+
+	field.temperature = elementArray[0].getTemperatureAddress();
+	field.xCount = xElementCountMax;
+	field.yCount = yElementCountMax;
+	field.zCount = zAllocEnd - zAllocBegin;
+	field.zBegin = zAllocBegin;
+
+	return field;
+}
+
+int ThermalStack::getElementBlock(int x, int y, int z)
+{
+	if (elementArray == nullptr) {
+		return -1;
+	}
+
+	MeshElement * elementPtr = nav3DArray(x, y, z);
+	if (elementPtr == nullptr) {
+		return -1;
+	}
+
+	return elementPtr->getBlockIndex();
+}
+
+// Marches the solution to convergence, outputs data realtime, outputs report after converging
+void ThermalStack::solve() 
+{
+
+	clock_t startTime = clock(); //Start timer
+
+	// a repeated solve marches on from the current field, e.g. after editing a block
+	if (currTime > timeStep) {
+		for (int i = 0; i < tracedBlocks.size(); i++) {
+			blocks[tracedBlocks[i]].rewindPowerTrace();
+		}
+	}
+	currTime = timeStep;
+	tempHistory.clear();
+
+	// the time constant and convergence time depend on the starting field, so only runs from a uniform
+	// startingTemperature are looked up in or added to the result cache
+	bool cacheable = (resultCache != nullptr && isAtStartingTemperature());
+
+	if (cacheable && useCachedResult(false)) {
+		return;
+	}
+
+	double initialMonitoredTemperature = getGlobalBulkTemp(blockIndex);
+	previousTemperature = initialMonitoredTemperature;
+
+	*console << "\nThermal stack initial state:\n\n";
+	illustrate();
+	*console << "\n";
+
+	*console << std::fixed;
+	*console << std::setprecision(0);
+
+	*console << "Solving...\n\n";
+	*console << "    Monitoring block " << blockIndex << ", " << blocks[blockIndex].getMaterialName()
+		<< ", generating " << blocks[blockIndex].getQGen() << " W\n";
+
+	*console << std::setprecision(2);
+	*console << "    Mesh Size = " << meshSize << " mm\n";
+	*console << std::setprecision(6);
+	*console << "    Time Step = " << timeStep << " sec\n";
+	*console << "    Sampling Time Inverval = " << timeStep * sampleIntervalSteps << " sec\n";
+	*console << std::setprecision(3);
+	*console << "    Convergence dT/dt_Target = " << deltaTConvergenceThreshold / (timeStep * sampleIntervalSteps) << " C/sec\n";
+	if (!tracedBlocks.empty()) {
+		*console << "    Power traces play until t = " << traceEndTime << " sec\n";
+	}
+	*console << "\n";
+	*console << "    t = " << 0 << " seconds         T_avg = " << initialMonitoredTemperature << " C\n";
+
+	bool haveIConvergedYet = false;
+	int currStep = 0;
+	int tauInterval = 0;
+	double tauTime = 0;
+	double currMonitoredTemperature = 0;
+
+	// wall-clock bookkeeping for progress throttling and instrumentation, touched only at sample points
+	std::chrono::steady_clock::time_point sampleEndAt = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point lastProgressAt = sampleEndAt;
+	long lastProgressStep = 0;
+
+	// history, throughput and progress output are handled on the reporter thread
+	SampleReporter reporter([&](const MonitorSample & sample) {
+
+		tempHistory.push_back(sample.monitoredTemperature);
+
+		if (instrumentation != nullptr) {
+			instrumentation->recordStepRate(sample.step, sample.time);
+		}
+
+		double secondsSinceProgress = std::chrono::duration<double>(sample.sampledAt - lastProgressAt).count();
+
+		if (progressCallback && isFirstProcess() && secondsSinceProgress >= progressMinIntervalSeconds) {
+			SolveProgress progress;
+			progress.step = sample.step;
+			progress.time = sample.time;
+			progress.monitoredTemperature = sample.monitoredTemperature;
+			progress.dTdt = sample.dTdt;
+			progress.stepsPerSecond = 0;
+			if (secondsSinceProgress > 0) {
+				progress.stepsPerSecond = (sample.step - lastProgressStep) / secondsSinceProgress;
+			}
+			progressCallback(progress);
+
+			lastProgressAt = sample.sampledAt;
+			lastProgressStep = sample.step;
+		}
+	});
+
+	while (haveIConvergedYet == false) {
+
+		advanceOneStep();
+		currStep = currTime / timeStep;
+
+		if (currStep % sampleIntervalSteps == 0) {
+
+			std::chrono::steady_clock::time_point sampleStartAt = std::chrono::steady_clock::now();
+			if (instrumentation != nullptr) {
+				instrumentation->addPhaseTime("stepping", std::chrono::duration<double>(sampleStartAt - sampleEndAt).count());
+			}
+
+			currMonitoredTemperature = getGlobalBulkTemp(blockIndex);
+
+			MonitorSample sample;
+			sample.step = currStep;
+			sample.time = currTime;
+			sample.monitoredTemperature = currMonitoredTemperature;
+			sample.dTdt = (currMonitoredTemperature - previousTemperature) / (timeStep * sampleIntervalSteps);
+			sample.sampledAt = sampleStartAt;
+			reporter.publish(sample);
+
+			// not converged while still changing, or while any power trace is still playing
+			// this comparison is all the stepping thread decides; the reporter is only waited on once converged
+			if (fabs(currMonitoredTemperature - previousTemperature) <= deltaTConvergenceThreshold && currTime >= traceEndTime) {
+
+				reporter.drain();
+
+				tauInterval = locateTauStep(initialMonitoredTemperature, currMonitoredTemperature);
+				tauTime = tauInterval * sampleIntervalSteps * timeStep;
+				*console << "                                                                                                           \r";
+				*console << "    t = " << tauTime << " seconds     T_avg = " << tempHistory[tauInterval] << " C"
+					<< "  \t<- @ one time constant\n";
+				*console << "    t = " << currTime << " seconds     T_avg = " << currMonitoredTemperature << " C"
+					<< "  \t<- @ steady state\n";
+
+				int secondsElapsed = (clock() - startTime) / CLOCKS_PER_SEC;
+				int minutesElapsed = floor(secondsElapsed / 60);
+				int secondsRemainder = secondsElapsed % 60;
+				
+				*console << "\nConverged on the following solution after " 
+					<< minutesElapsed << " minutes and "  << secondsRemainder << " seconds";
+				haveIConvergedYet = true;
+			}
+			previousTemperature = currMonitoredTemperature;
+
+			sampleEndAt = std::chrono::steady_clock::now();
+			if (instrumentation != nullptr) {
+				instrumentation->addPhaseTime("sampling", std::chrono::duration<double>(sampleEndAt - sampleStartAt).count());
+			}
+		}
+	}
+
+	*console << "\n\n";
+	illustrate();
+	*console << "\n";
+
+	double thermalImpedance = (currMonitoredTemperature - getImpedanceReferenceTemperature()) / blocks[blockIndex].getQGen();
+
+	*console << std::fixed;
+	*console << std::setprecision(3);
+	*console << "Thermal impedance, heat source to infinite heatsink = " << thermalImpedance << " K/W \n\n";
+
+	CachedResult result;
+	result.steady = false;
+	result.time = currTime;
+	result.monitoredTemperature = currMonitoredTemperature;
+	result.tauTime = tauTime;
+	result.tauTemperature = tempHistory[tauInterval];
+	result.thermalImpedance = thermalImpedance;
+	if (cacheable) {
+		storeResult(result);
+	}
+
+	if (instrumentation != nullptr && isFirstProcess()) {
+		instrumentation->setResult(haveIConvergedYet, currStep, currTime, currMonitoredTemperature, thermalImpedance);
+		if (instrumentation->writeJsonReport(reportPath)) {
+			*console << "Run report written to " << reportPath << "\n\n";
+		}
+		else {
+			*console << "Could not write run report to " << reportPath << "\n\n";
+		}
+	}
+}
+
+// Steady solves run on a single process and need the model tied to an ambient
+bool ThermalStack::canSolveSteady()
+{
+	if (decomposition != nullptr) {
+		*console << "Steady-state solves are not available for decomposed models, use solve()" << std::endl;
+		return false;
+	}
+
+	if (boundaryVector.empty()) {
+		*console << "Steady-state solves need at least one convection boundary, see setConvectionTop()" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+// Film-conductance-weighted mean of the boundary ambients, the starting temperature if there is no convection
+double ThermalStack::getImpedanceReferenceTemperature()
+{
+	double partials[2] = { 0, 0 };
+
+	for (int i = 0; i < boundaryVector.size(); i++) {
+		double filmConductance = 1 / boundaryVector[i].getFilmResistance();
+		partials[0] += filmConductance;
+		partials[1] += filmConductance * boundaryVector[i].getAmbientTemperature();
+	}
+
+	if (decomposition != nullptr) {
+		decomposition->sum(partials, 2);
+	}
+
+	if (partials[0] <= 0) {
+		return startingTemperature;
+	}
+
+	return partials[1] / partials[0];
+}
+
+// Numbers the active elements densely, in array order
+void ThermalStack::indexSteadyUnknowns()
+{
+	steadyIndices.assign(totalElementCount, -1);
+	steadyUnknowns.clear();
+
+	for (int i = 0; i < totalElementCount; i++) {
+		if (!elementArray[i].isEmpty()) {
+			steadyIndices[i] = steadyUnknowns.size();
+			steadyUnknowns.push_back(&elementArray[i]);
+		}
+	}
+}
+
+int ThermalStack::steadyIndexOf(MeshElement * element)
+{
+	return steadyIndices[element - elementArray];
+}
+
+// Builds G and q from the same links, boundaries and heat generation the transient solver uses
+SteadyStateSolver ThermalStack::assembleSteadySystem()
+{
+	indexSteadyUnknowns();
+	refreshConductances(nullptr);
+
+	SteadyStateSolver system(steadyUnknowns.size());
+
+	for (int i = 0; i < nodeVector.size(); i++) {
+		system.addLink(steadyIndexOf(nodeVector[i].getFirst()),
+					   steadyIndexOf(nodeVector[i].getSecond()),
+					   1 / nodeVector[i].getResistanceAbsolute());
+	}
+
+	for (int i = 0; i < boundaryVector.size(); i++) {
+		system.addBoundary(steadyIndexOf(boundaryVector[i].getElement()),
+						   1 / boundaryVector[i].getResistanceAbsolute(),
+						   boundaryVector[i].getAmbientTemperature());
+	}
+
+	for (int i = 0; i < steadyUnknowns.size(); i++) {
+		system.addSource(i, blocks[steadyUnknowns[i]->getBlockIndex()].getQGenElement());
+	}
+
+	return system;
+}
+
+// Solves the assembled system, starting from and writing back to the element temperatures
+bool ThermalStack::solveSteadyField(SteadyStateSolver & system, std::vector<double> & temperatures)
+{
+	temperatures.resize(steadyUnknowns.size());
+	for (int i = 0; i < steadyUnknowns.size(); i++) {
+		temperatures[i] = steadyUnknowns[i]->getTemperature();
+	}
+
+	int iterations = system.solve(system.getLoad(), temperatures, 1e-10, 20 * steadyUnknowns.size() + 100);
+	int totalIterations = iterations;
+
+	for (int i = 0; i < steadyUnknowns.size(); i++) {
+		steadyUnknowns[i]->setTemperature(temperatures[i]);
+	}
+
+	// Picard iteration for k(T) materials: conductances follow the new field, the system and its Jacobi preconditioner
+	// are patched in place, and CG restarts from the previous solution until no element drifts past the tolerance
+	int picardIterations = 0;
+
+	while (iterations >= 0 && picardIterations < 100 && refreshConductances(&system) > 0) {
+
+		iterations = system.solve(system.getLoad(), temperatures, 1e-10, 20 * steadyUnknowns.size() + 100);
+		totalIterations += iterations;
+		picardIterations++;
+
+		for (int i = 0; i < steadyUnknowns.size(); i++) {
+			steadyUnknowns[i]->setTemperature(temperatures[i]);
+		}
+	}
+
+	if (iterations < 0) {
+		*console << "Steady-state solve did not converge" << std::endl;
+		return false;
+	}
+
+	*console << "Steady-state solution after " << totalIterations << " conjugate gradient iterations";
+	if (picardIterations > 0) {
+		*console << " over " << picardIterations + 1 << " conductance updates";
+	}
+	*console << std::endl;
+	return true;
+}
+
+// Direct steady-state counterpart to solve()
+void ThermalStack::solveSteady()
+{
+	if (!canSolveSteady()) {
+		return;
+	}
+
+	if (useCachedResult(true)) {
+		return;
+	}
+
+	*console << "\nSolving for steady state...\n\n";
+
+	SteadyStateSolver system = assembleSteadySystem();
+	std::vector<double> temperatures;
+	bool converged = solveSteadyField(system, temperatures);
+
+	*console << "\n";
+	illustrate();
+	*console << "\n";
+
+	double thermalImpedance = (getGlobalBulkTemp(blockIndex) - getImpedanceReferenceTemperature()) / blocks[blockIndex].getQGen();
+
+	*console << std::fixed;
+	*console << std::setprecision(3);
+	*console << "Thermal impedance, heat source to infinite heatsink = " << thermalImpedance << " K/W \n\n";
+
+	if (converged) {
+		CachedResult result;
+		result.steady = true;
+		result.time = 0;
+		result.monitoredTemperature = getGlobalBulkTemp(blockIndex);
+		result.tauTime = 0;
+		result.tauTemperature = 0;
+		result.thermalImpedance = thermalImpedance;
+		storeResult(result);
+	}
+}
+
+// Adjoint method: with Z = w.T - T_ref/Q, where w averages the monitored block and divides by its power, G T = q,
+// and the ambient reference T_ref held fixed,
+// dZ/dp = -lambda.(dG/dp T - dq/dp) with G lambda = w (G is symmetric).
+// Every conductance g = 1/R contributes (lambda_i - lambda_j)(T_i - T_j) g^2 dR/dp, so only the derivatives
+// of each link's resistance terms with respect to k, thickness and interface resistance are needed.
+ImpedanceSensitivities ThermalStack::computeSensitivities()
+{
+	ImpedanceSensitivities sensitivities;
+	sensitivities.thermalImpedance = 0;
+	sensitivities.dZdk.assign(blocks.size(), 0);
+	sensitivities.dZdThickness.assign(blocks.size(), 0);
+	sensitivities.dZdInterface.assign(layerBlocks.size(), 0);
+
+	if (!canSolveSteady()) {
+		return sensitivities;
+	}
+
+	// forward solve
+	SteadyStateSolver system = assembleSteadySystem();
+	std::vector<double> temperatures;
+	if (!solveSteadyField(system, temperatures)) {
+		return sensitivities;
+	}
+
+	double qMonitored = blocks[blockIndex].getQGen();
+	sensitivities.thermalImpedance = (getGlobalBulkTemp(blockIndex) - getImpedanceReferenceTemperature()) / qMonitored;
+
+	// adjoint solve
+	std::vector<double> impedanceWeights(steadyUnknowns.size(), 0);
+	double weight = 1.0 / (blocks[blockIndex].getElementVectorCount() * qMonitored);
+	for (int i = 0; i < steadyUnknowns.size(); i++) {
+		if (steadyUnknowns[i]->getBlockIndex() == blockIndex) {
+			impedanceWeights[i] = weight;
+		}
+	}
+
+	std::vector<double> adjoint(steadyUnknowns.size(), 0);
+	if (system.solve(impedanceWeights, adjoint, 1e-10, 20 * steadyUnknowns.size() + 100) < 0) {
+		*console << "Adjoint solve did not converge" << std::endl;
+		return sensitivities;
+	}
+
+	// element-element links
+	for (int l = 0; l < nodeVector.size(); l++) {
+
+		MeshNode & link = nodeVector[l];
+		int i = steadyIndexOf(link.getFirst());
+		int j = steadyIndexOf(link.getSecond());
+		double g = 1 / link.getResistanceAbsolute();
+		double dZdR = (adjoint[i] - adjoint[j]) * (temperatures[i] - temperatures[j]) * g * g;
+
+		MeshElement * ends[2] = { link.getFirst(), link.getSecond() };
+
+		for (int e = 0; e < 2; e++) {
+			int b = ends[e]->getBlockIndex();
+			double half = link.isZLink() ? ends[e]->getZRAbsolute() : ends[e]->getXYRAbsolute();
+
+			// half resistances scale with 1/k; z halves grow with thickness, x/y halves shrink with it
+			sensitivities.dZdk[b] += dZdR * (-half / blocks[b].getK());
+			sensitivities.dZdThickness[b] += dZdR * (link.isZLink() ? half : -half) / blocks[b].getZLength();
+		}
+
+		int firstLayer = zLayerIndices[link.getFirst()->getZLayer()];
+		int secondLayer = zLayerIndices[link.getSecond()->getZLayer()];
+
+		if (firstLayer != secondLayer) {
+			double contactArea = std::min(blocks[link.getFirst()->getBlockIndex()].getElementFaceArea(),
+										  blocks[link.getSecond()->getBlockIndex()].getElementFaceArea());
+			sensitivities.dZdInterface[std::min(firstLayer, secondLayer)] += dZdR / contactArea;
+		}
+	}
+
+	// convection boundaries, the ambient side carries no adjoint
+	for (int l = 0; l < boundaryVector.size(); l++) {
+
+		MeshBoundary & boundary = boundaryVector[l];
+		int i = steadyIndexOf(boundary.getElement());
+		double g = 1 / boundary.getResistanceAbsolute();
+		double dZdR = adjoint[i] * (temperatures[i] - boundary.getAmbientTemperature()) * g * g;
+
+		int b = boundary.getElement()->getBlockIndex();
+		double half = boundary.getHalfResistance();
+		double thickness = blocks[b].getZLength();
+
+		sensitivities.dZdk[b] += dZdR * (-half / blocks[b].getK());
+
+		// side faces: the half resistance and the film both shrink as the face gets taller
+		if (boundary.isSideFace()) {
+			sensitivities.dZdThickness[b] += dZdR * (-half - boundary.getFilmResistance()) / thickness;
+		}
+		else {
+			sensitivities.dZdThickness[b] += dZdR * half / thickness;
+		}
+	}
+
+	double impedance = sensitivities.thermalImpedance;
+
+	*console << "\nImpedance sensitivities, Z = " << std::fixed << std::setprecision(4) << impedance << " K/W\n\n";
+	*console << "                 Matl        dZ/dk [K/W / W/mmK]   (k/Z)dZ/dk    dZ/dt [K/W / mm]   (t/Z)dZ/dt\n\n";
+
+	for (int i = 0; i < blocks.size(); i++) {
+		*console << "    Block " << i << "\t " << blocks[i].getMaterialName() << "  "
+				 << std::scientific << std::setprecision(3)
+				 << "    " << std::setw(10) << sensitivities.dZdk[i]
+				 << std::fixed << std::setprecision(4)
+				 << "        " << std::setw(8) << sensitivities.dZdk[i] * blocks[i].getK() / impedance
+				 << std::scientific << std::setprecision(3)
+				 << "      " << std::setw(10) << sensitivities.dZdThickness[i]
+				 << std::fixed << std::setprecision(4)
+				 << "       " << std::setw(8) << sensitivities.dZdThickness[i] * blocks[i].getZLength() / impedance
+				 << "\n";
+	}
+
+	*console << "\n                             dZ/dR\" [K/W / K*mm^2/W]   (R\"/Z)dZ/dR\"\n\n";
+
+	for (int i = 0; i + 1 < layerBlocks.size(); i++) {
+		*console << "    Interface " << i << "/" << i + 1 << "\t     "
+				 << std::scientific << std::setprecision(3)
+				 << "    " << std::setw(10) << sensitivities.dZdInterface[i]
+				 << std::fixed << std::setprecision(4)
+				 << "             " << std::setw(8) << sensitivities.dZdInterface[i] * interfaceResistances[i] / impedance
+				 << "\n";
+	}
+	*console << "\n";
+
+	return sensitivities;
+}
+
+// Modal expansion of the transient: with G v = lambda C v and v.C.v = 1, the monitored block's temperature is
+// T(t) = T_ss - sum over modes of a (exp(-t / tau)), with a = (w.v)(v.r) tau and r = q - G T_start.
+ThermalModes ThermalStack::computeTimeConstants(int modeCount)
+{
+	ThermalModes thermalModes;
+	thermalModes.temperatureRise = 0;
+	thermalModes.unconvergedModes = 0;
+
+	if (!canSolveSteady()) {
+		return thermalModes;
+	}
+
+	SteadyStateSolver system = assembleSteadySystem();
+	int unknownCount = steadyUnknowns.size();
+
+	std::vector<double> capacitance(unknownCount);
+	for (int i = 0; i < unknownCount; i++) {
+		capacitance[i] = steadyUnknowns[i]->getCElement();
+	}
+
+	// net heat flow into each element at t = 0 of a transient from the uniform starting temperature
+	std::vector<double> startingField(unknownCount, startingTemperature);
+	std::vector<double> drive;
+	system.multiply(startingField, drive);
+	for (int i = 0; i < unknownCount; i++) {
+		drive[i] = system.getLoad()[i] - drive[i];
+	}
+
+	std::vector<double> monitorWeights(unknownCount, 0);
+	double weight = 1.0 / blocks[blockIndex].getElementVectorCount();
+	for (int i = 0; i < unknownCount; i++) {
+		if (steadyUnknowns[i]->getBlockIndex() == blockIndex) {
+			monitorWeights[i] = weight;
+		}
+	}
+
+	std::vector<double> rise(unknownCount, 0);
+	if (system.solve(drive, rise, 1e-10, 20 * unknownCount + 100) < 0) {
+		*console << "Steady-state solve did not converge" << std::endl;
+		return thermalModes;
+	}
+	for (int i = 0; i < unknownCount; i++) {
+		thermalModes.temperatureRise += monitorWeights[i] * rise[i];
+	}
+
+	ThermalModeSolver modeSolver(system, capacitance);
+	std::vector<std::vector<double> > modes;
+	int modesFound = modeSolver.solve(modeCount, thermalModes.timeConstants, modes);
+	thermalModes.unconvergedModes = modeSolver.getUnconvergedCount();
+	if (modesFound < 0) {
+		*console << "Steady-state solve did not converge" << std::endl;
+		return thermalModes;
+	}
+
+	double participationSum = 0;
+
+	for (int k = 0; k < modesFound; k++) {
+
+		double monitored = 0;
+		double driven = 0;
+		for (int i = 0; i < unknownCount; i++) {
+			monitored += monitorWeights[i] * modes[k][i];
+			driven += modes[k][i] * drive[i];
+		}
+
+		double amplitude = monitored * driven * thermalModes.timeConstants[k];
+		double participation = thermalModes.temperatureRise != 0 ? amplitude / thermalModes.temperatureRise : 0;
+
+		thermalModes.amplitudes.push_back(amplitude);
+		thermalModes.participation.push_back(participation);
+		participationSum += participation;
+	}
+
+	*console << "\nThermal time constants after " << modeSolver.getStepCount() << " Lanczos steps\n\n";
+	*console << "              tau [sec]      Amplitude [C]    Participation\n\n";
+
+	for (int k = 0; k < modesFound; k++) {
+		*console << "    Mode " << k << "\t"
+				 << std::fixed << std::setprecision(4)
+				 << std::setw(10) << thermalModes.timeConstants[k]
+				 << std::setprecision(3)
+				 << "       " << std::setw(10) << thermalModes.amplitudes[k]
+				 << std::setprecision(1)
+				 << "       " << std::setw(6) << thermalModes.participation[k] * 100 << " %\n";
+	}
+
+	// modes that did not converge are left out, so a listed mode need not be the k-th slowest
+	if (thermalModes.unconvergedModes > 0) {
+		*console << "\n    Only " << modesFound << " of " << modeCount << " requested modes converged; "
+				 << thermalModes.unconvergedModes << " are left out of this list\n";
+	}
+
+	*console << "\nListed modes carry " << std::setprecision(1) << participationSum * 100
+			 << " % of the monitored block's " << std::setprecision(3) << thermalModes.temperatureRise << " C rise\n\n";
+
+	return thermalModes;
+}
+
+void ThermalStack::copyStackDefinition(ThermalStack & source)
+{
+	for (int layer = 0; layer < source.layerBlocks.size(); layer++) {
+
+		for (int i = 0; i < source.layerBlocks[layer].size(); i++) {
+
+			Block & block = source.blocks[source.layerBlocks[layer][i]];
+			Material material = block.getMaterial();
+
+			if (i == 0) {
+				addBlock(block.getXLength(), block.getYLength(), block.getZLength(),
+						 block.getXOffset(), block.getYOffset(), material, block.getQGen());
+			}
+			else {
+				addBlockToLayer(block.getXLength(), block.getYLength(),
+								block.getXOffset(), block.getYOffset(), material, block.getQGen());
+			}
+
+			if (block.hasPowerTrace()) {
+				setBlockPowerTrace(blocks.size() - 1, block.getPowerTracePath());
+			}
+		}
+
+		interfaceResistances.back() = source.interfaceResistances[layer];
+	}
+
+	setConvectionBottom(source.hBottom, source.ambientBottom);
+	setConvectionTop(source.hTop, source.ambientTop);
+	setConvectionSides(source.hSides, source.ambientSides);
+	setConductanceTolerance(source.conductanceTolerance);
+	monitorBlock(source.blockIndex);
+}
+
+// Every mesh size runs on its own thread with its own copy of the stack; results land in per-size slots
+MeshConvergenceReport ThermalStack::studyMeshConvergence(std::vector<double> meshSizes, double relativeTolerance)
+{
+	MeshConvergenceReport report;
+	report.extrapolatedImpedance = 0;
+	report.observedOrder = 0;
+	report.recommendedMeshSize = 0;
+	report.predictedMeshSize = 0;
+
+	if (decomposition != nullptr) {
+		*console << "Mesh convergence studies run on a single process" << std::endl;
+		return report;
+	}
+
+	if (meshSizes.size() < 2) {
+		*console << "Mesh convergence studies need at least two mesh sizes" << std::endl;
+		return report;
+	}
+
+	// Z and the block temperature errors are both scaled by the monitored block's power
+	if (blockIndex < 0 || blockIndex >= blocks.size() || blocks[blockIndex].getQGen() == 0) {
+		*console << "Mesh convergence studies need monitorBlock() to name a block that generates heat" << std::endl;
+		return report;
+	}
+
+	std::sort(meshSizes.begin(), meshSizes.end(), std::greater<double>());
+
+	int sizeCount = meshSizes.size();
+	bool steady = (hBottom > 0 || hTop > 0 || hSides > 0);
+
+	report.meshSizes = meshSizes;
+	report.elementCounts.assign(sizeCount, 0);
+	report.thermalImpedances.assign(sizeCount, 0);
+	report.blockTemperatures.assign(sizeCount, std::vector<double>(blocks.size(), 0));
+	report.estimatedErrors.assign(sizeCount, 0);
+
+	*console << "\nMesh convergence study, " << sizeCount << (steady ? " steady-state" : " transient")
+			 << " solves running concurrently...\n\n";
+
+	std::vector<std::thread> workers;
+
+	for (int i = 0; i < sizeCount; i++) {
+		workers.push_back(std::thread([this, &report, i, steady]() {
+
+			double size = report.meshSizes[i];
+
+			// explicit stepping stays stable only if the time step shrinks with the element size squared
+			double stepScale = std::min(1.0, (size / meshSize) * (size / meshSize));
+			int sampleSteps = std::max(1, (int)round(sampleIntervalSteps / stepScale));
+
+			ThermalStack study(size, timeStep * stepScale, sampleSteps, deltaTConvergenceThreshold, startingTemperature);
+			study.setQuiet(true);
+			study.copyStackDefinition(*this);
+			study.mesh();
+
+			if (steady) {
+				study.solveSteady();
+			}
+			else {
+				study.solve();
+			}
+
+			report.elementCounts[i] = study.activeElementCount;
+			for (int b = 0; b < blocks.size(); b++) {
+				report.blockTemperatures[i][b] = study.getGlobalBulkTemp(b);
+			}
+			report.thermalImpedances[i] = (report.blockTemperatures[i][blockIndex] - study.getImpedanceReferenceTemperature()) / blocks[blockIndex].getQGen();
+		}));
+	}
+
+	for (int i = 0; i < workers.size(); i++) {
+		workers[i].join();
+	}
+
+	RichardsonExtrapolation impedance(report.meshSizes, report.thermalImpedances);
+	report.extrapolatedImpedance = impedance.getExtrapolatedValue();
+	report.observedOrder = impedance.getObservedOrder();
+
+	double impedanceScale = fabs(report.extrapolatedImpedance);
+	report.predictedMeshSize = impedance.predictMeshSize(relativeTolerance * impedanceScale);
+
+	for (int i = 0; i < sizeCount; i++) {
+		report.estimatedErrors[i] = impedance.getErrorEstimate(i) / impedanceScale;
+	}
+
+	// block temperatures are judged against the monitored block's rise, not their absolute value in C
+	double temperatureScale = fabs(report.extrapolatedImpedance * blocks[blockIndex].getQGen());
+
+	for (int b = 0; b < blocks.size() && temperatureScale > 0; b++) {
+
+		std::vector<double> temperatures(sizeCount);
+		for (int i = 0; i < sizeCount; i++) {
+			temperatures[i] = report.blockTemperatures[i][b];
+		}
+
+		RichardsonExtrapolation temperature(report.meshSizes, temperatures);
+
+		for (int i = 0; i < sizeCount; i++) {
+			report.estimatedErrors[i] = std::max(report.estimatedErrors[i], temperature.getErrorEstimate(i) / temperatureScale);
+		}
+
+		double predicted = temperature.predictMeshSize(relativeTolerance * temperatureScale);
+		if (predicted > 0 && (report.predictedMeshSize == 0 || predicted < report.predictedMeshSize)) {
+			report.predictedMeshSize = predicted;
+		}
+	}
+
+	for (int i = 0; i < sizeCount; i++) {
+		if (report.estimatedErrors[i] <= relativeTolerance) {
+			report.recommendedMeshSize = report.meshSizes[i];
+			break;
+		}
+	}
+
+	*console << std::fixed;
+	*console << "    Mesh [mm]     Elements      Z [K/W]     Est. error\n\n";
+
+	for (int i = 0; i < sizeCount; i++) {
+		*console << "    " << std::setprecision(3) << std::setw(8) << report.meshSizes[i]
+				 << "     " << std::setw(8) << report.elementCounts[i]
+				 << "     " << std::setprecision(4) << std::setw(8) << report.thermalImpedances[i]
+				 << "     " << std::setprecision(2) << std::setw(8) << report.estimatedErrors[i] * 100 << " %\n";
+	}
+
+	*console << "\n    Extrapolated Z = " << std::setprecision(4) << report.extrapolatedImpedance << " K/W, order of convergence "
+			 << std::setprecision(2) << report.observedOrder << (impedance.isOrderObserved() ? " (observed)" : " (assumed)") << "\n";
+
+	if (report.recommendedMeshSize > 0) {
+		*console << "    Coarsest mesh within " << relativeTolerance * 100 << " %: " << std::setprecision(3)
+				 << report.recommendedMeshSize << " mm";
+	}
+	else {
+		*console << "    No studied mesh is within " << relativeTolerance * 100 << " %";
+	}
+
+	if (report.predictedMeshSize > 0) {
+		*console << ", predicted size to just meet it: " << std::setprecision(3) << report.predictedMeshSize << " mm";
+	}
+	*console << "\n\n";
+
+	return report;
+}
+
+// Doubles are written in hex so that equal values always give equal text
+std::string ThermalStack::canonicalGeometry()
+{
+	std::ostringstream text;
+	text << std::hexfloat;
+	text << "mesh " << meshSize << "\n";
+
+	for (int layer = 0; layer < layerBlocks.size(); layer++) {
+		for (int i = 0; i < layerBlocks[layer].size(); i++) {
+			Block & block = blocks[layerBlocks[layer][i]];
+			text << "block " << layer << " " << block.getXLength() << " " << block.getYLength() << " " << block.getZLength()
+				 << " " << block.getXOffset() << " " << block.getYOffset() << "\n";
+		}
+	}
+
+	return text.str();
+}
+
+std::string ThermalStack::canonicalConfiguration(bool steady)
+{
+	std::ostringstream text;
+	text << canonicalGeometry();
+	text << std::hexfloat;
+
+	for (int i = 0; i < blocks.size(); i++) {
+		text << "material " << blocks[i].getK() << " " << blocks[i].getC();
+		Material material = blocks[i].getMaterial();
+		for (int j = 0; j < material.kTemperatures.size(); j++) {
+			text << " k(" << material.kTemperatures[j] << ") " << material.kValues[j];
+		}
+		// keyed by content rather than path, so a log rewritten in place is not mistaken for the cached one
+		if (blocks[i].hasPowerTrace()) {
+			text << " trace " << ResultCache::hashFile(blocks[i].getPowerTracePath()) << " " << blocks[i].getPowerTraceEndTime() << "\n";
+		}
+		else {
+			text << " power " << blocks[i].getQGen() << "\n";
+		}
+	}
+
+	for (int i = 0; i < interfaceResistances.size(); i++) {
+		text << "interface " << interfaceResistances[i] << "\n";
+	}
+
+	text << "convection " << hBottom << " " << ambientBottom << " " << hTop << " " << ambientTop
+		 << " " << hSides << " " << ambientSides << "\n";
+	text << "start " << startingTemperature << " monitor " << blockIndex << "\n";
+
+	if (steady) {
+		text << "solver steady " << conductanceTolerance << "\n";
+	}
+	else {
+		text << "solver transient " << timeStep << " " << sampleIntervalSteps << " " << deltaTConvergenceThreshold
+			 << " " << conductanceTolerance << "\n";
+	}
+
+	return text.str();
+}
+
+std::vector<double> ThermalStack::getActiveTemperatures()
+{
+	std::vector<double> temperatures;
+	for (int i = 0; i < totalElementCount; i++) {
+		if (!elementArray[i].isEmpty()) {
+			temperatures.push_back(elementArray[i].getTemperature());
+		}
+	}
+	return temperatures;
+}
+
+bool ThermalStack::setActiveTemperatures(const std::vector<double> & temperatures)
+{
+	int activeCount = 0;
+	for (int i = 0; i < totalElementCount; i++) {
+		if (!elementArray[i].isEmpty()) {
+			activeCount++;
+		}
+	}
+
+	if (activeCount != temperatures.size()) {
+		return false;
+	}
+
+	int next = 0;
+	for (int i = 0; i < totalElementCount; i++) {
+		if (!elementArray[i].isEmpty()) {
+			elementArray[i].setTemperature(temperatures[next++]);
+		}
+	}
+	return true;
+}
+
+// Reports an exact cache hit in place of solving and returns true; otherwise a steady solve warm-starts from a
+// geometry match if any. Transient runs are never warm-started, since their result depends on the starting field.
+bool ThermalStack::useCachedResult(bool steady)
+{
+	if (resultCache == nullptr || decomposition != nullptr || elementArray == nullptr) {
+		return false;
+	}
+
+	CachedResult cached;
+
+	if (resultCache->load(canonicalConfiguration(steady), cached) && setActiveTemperatures(cached.temperatures)) {
+
+		*console << "\nFound this configuration in the result cache\n\n";
+		*console << std::fixed;
+		*console << std::setprecision(3);
+
+		if (!steady) {
+			currTime = cached.time;
+			*console << "    t = " << cached.tauTime << " seconds     T_avg = " << cached.tauTemperature << " C"
+				<< "  \t<- @ one time constant\n";
+			*console << "    t = " << cached.time << " seconds     T_avg = " << cached.monitoredTemperature << " C"
+				<< "  \t<- @ steady state\n\n";
+		}
+
+		illustrate();
+		*console << "\n";
+
+		*console << std::fixed;
+		*console << std::setprecision(3);
+		*console << "Thermal impedance, heat source to infinite heatsink = " << cached.thermalImpedance << " K/W \n\n";
+		return true;
+	}
+
+	if (steady && resultCache->loadLatestWithGeometry(canonicalGeometry(), cached) && setActiveTemperatures(cached.temperatures)) {
+		*console << "\nWarm start from a cached solution with the same geometry\n";
+	}
+
+	return false;
+}
+
+bool ThermalStack::isAtStartingTemperature()
+{
+	if (elementArray == nullptr) {
+		return false;
+	}
+
+	for (int i = 0; i < totalElementCount; i++) {
+		if (!elementArray[i].isEmpty() && elementArray[i].getTemperature() != startingTemperature) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void ThermalStack::storeResult(CachedResult & result)
+{
+	if (resultCache == nullptr || decomposition != nullptr) {
+		return;
+	}
+
+	result.temperatures = getActiveTemperatures();
+
+	if (!resultCache->store(canonicalConfiguration(result.steady), canonicalGeometry(), result)) {
+		*console << "Could not write to the result cache" << std::endl;
+	}
+}
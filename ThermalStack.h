@@ -16,7 +16,65 @@
 #include "Block.h"
 #include "MeshElement.h"
 #include "MeshNode.h"
+#include "MeshBoundary.h"
+#include "RunInstrumentation.h"
+#include "DomainDecomposition.h"
+#include "SteadyStateSolver.h"
+#include "ThermalModeSolver.h"
+#include "RichardsonExtrapolation.h"
+#include "ResultCache.h"
 #include <vector>
+#include <string>
+#include <ostream>
+#include <cstddef>
+
+// Derivatives of the monitored block's thermal impedance, see ThermalStack::computeSensitivities()
+struct ImpedanceSensitivities {
+	double thermalImpedance;			// [K/W]
+	std::vector<double> dZdk;			// per block [K/W per W/mmK]
+	std::vector<double> dZdThickness;	// per block [K/W per mm]
+	std::vector<double> dZdInterface;	// per layer, interface to the layer above [K/W per K*mm^2/W]
+};
+
+// Slowest thermal eigenmodes and their share of the monitored block's response, see ThermalStack::computeTimeConstants()
+struct ThermalModes {
+	std::vector<double> timeConstants;	// slowest first [sec]
+	std::vector<double> amplitudes;		// each mode's contribution to the monitored block's temperature rise [C]
+	std::vector<double> participation;	// amplitude as a fraction of the total rise
+	double temperatureRise;				// monitored block, starting temperature to steady state [C]
+	int unconvergedModes;				// requested modes that did not converge and are left out of the lists above
+};
+
+// Results of ThermalStack::studyMeshConvergence(), one entry per mesh size, coarsest first
+struct MeshConvergenceReport {
+	std::vector<double> meshSizes;							// [mm]
+	std::vector<int> elementCounts;							// active elements
+	std::vector<double> thermalImpedances;					// [K/W]
+	std::vector<std::vector<double> > blockTemperatures;	// mean of each block [C]
+	std::vector<double> estimatedErrors;					// worst relative error over impedance and block temperatures
+	double extrapolatedImpedance;							// [K/W]
+	double observedOrder;									// of the impedance, the formal order if not observable
+	double recommendedMeshSize;								// coarsest studied size within tolerance [mm], 0 if none
+	double predictedMeshSize;								// size expected to just meet the tolerance [mm]
+};
+
+// Temperatures and heat gen of one block, see ThermalStack::getBlockStatistics()
+struct BlockStatistics {
+	double meanTemperature;		// [C]
+	double minTemperature;		// [C]
+	double maxTemperature;		// [C]
+	double qGen;				// [W]
+};
+
+// Read-only view of the element temperatures where they live, see ThermalStack::getTemperatureField()
+struct TemperatureField {
+	const double * temperature;	// first element's temperature [C]
+	size_t stride;				// bytes from one element's temperature to the next
+	int xCount;					// elements held by this process, x varies fastest, then y, then z
+	int yCount;
+	int zCount;
+	int zBegin;					// global z-layer of the first held layer, 0 unless decomposed
+};
 
 class ThermalStack
 {
@@ -32,21 +90,126 @@ public:
 
 	~ThermalStack();
 
-	// Creates a new rectangular material mass/block -- and pushes it onto one end of the thermal stack.
-	// All blocks are centered in the X and Y
+	// Creates a new rectangular material mass/block -- and pushes it onto one end of the thermal stack as a new layer.
+	// Blocks are centered in the X and Y unless given an offset of their centre from the stack centreline [mm]
 	// Works like stack::push()
 	void addBlock(double xIn, double yIn, double zIn, Material materialIn, double qGenBlockIn);
+	void addBlock(double xIn, double yIn, double zIn, double xOffsetIn, double yOffsetIn, Material materialIn, double qGenBlockIn);
+
+	// Places another block side by side with the others in the most recently added layer, e.g. several dies on one substrate.
+	// The block takes the layer's thickness. Footprints within a layer should not overlap; where they do, the block
+	// added first keeps the overlapped elements and each other block's power is spread over the elements it keeps.
+	void addBlockToLayer(double xIn, double yIn, double xOffsetIn, double yOffsetIn, Material materialIn, double qGenBlockIn);
+
+	// Replaces a block's constant heat gen with a power-versus-time trace file, streamed while solving
+	// See PowerTrace.h for the file format. solve() runs at least until the end of the longest trace.
+	// Each time step generates the power the trace gives at the start of that step.
+	void setBlockPowerTrace(int blockIndexIn, std::string tracePathIn);
+
+	// Design edits, usable before or after mesh(). After mesh() only the edited block's elements, links and boundaries
+	// are recomputed and the temperature field is kept, so the next solve() or solveSteady() starts warm from it.
+	// A thickness applies to the block's whole layer. If it changes the layer's element count the stack is re-meshed,
+	// carrying temperatures over layer by layer.
+	void setBlockMaterial(int blockIndexIn, Material materialIn);
+	Material getBlockMaterial(int blockIndexIn);
+	void setBlockPower(int blockIndexIn, double qGenBlockIn);
+	void setBlockThickness(int blockIndexIn, double zIn);
+
+	// Blocks of a Material with a k(T) table have their element conductances follow the element temperatures.
+	// Refreshes are lazy: an element and its links are only recomputed once it has drifted more than
+	// toleranceIn [C] from the temperature its conductances were last computed at. Defaults to 0.1 C
+	void setConductanceTolerance(double toleranceIn);
+
+	// Places a zero-thickness contact resistance between the most recently added layer and the next one.
+	// Nothing is meshed for it; it is folded into the z-links that cross the interface.
+	// Input is area-specific resistance [K*mm^2/W], or a thin material layer and its thickness [mm]
+	void addInterface(double resistanceArealIn);
+	void addInterface(Material materialIn, double thicknessIn);
+
+	// Convective (Robin) boundary conditions on the outer faces of the stack, applied per exposed element face
+	// Inputs are (heat transfer coefficient h [W/mm^2K], ambient fluid temperature [C])
+	// Bottom is the first block added, top is the last. Sides cover every exposed X/Y face of every block.
+	// Call before mesh()
+	void setConvectionBottom(double hIn, double ambientTemperatureIn);
+	void setConvectionTop(double hIn, double ambientTemperatureIn);
+	void setConvectionSides(double hIn, double ambientTemperatureIn);
+
+	// Splits the stack's z-layers across the processes of a domain decomposition (see MPIDecomposition.h)
+	// Every process builds the same stack and calls this before mesh(); the caller keeps ownership.
+	// mesh() throws std::runtime_error on every process if there are more processes than z-layers of elements
+	void decompose(DomainDecomposition * decompositionIn);
 
 	// Prepares the user-defined block stackup for simulation
+	// Calling it again discards the previous mesh, its temperatures and elapsed time, and meshes the stack afresh
 	void mesh();
+	bool isMeshed();
 
 	// Specifies which block to monitor for convergence
 	// Block must be a heat source
 	void monitorBlock(int blockIndexIn);
 
 	// March the solution, outputs useful data
+	// Thermal impedance is reported from the convection ambient, the stack's heatsink, whatever the starting temperature.
+	// Boundaries at different ambients are averaged, weighted by their film conductance h * A. Without any convection
+	// boundary the starting temperature stands in, as it does for a massive heatsink block.
 	void solve();
 
+	// Solves for the steady-state temperature field directly instead of marching, then reports like solve()
+	// Needs at least one convection boundary to tie the model to an ambient temperature
+	void solveSteady();
+
+	// Sensitivity of the monitored block's thermal impedance to every block's conductivity and thickness,
+	// and to every interface resistance, from one steady solve and one adjoint solve on the existing mesh.
+	// Thickness derivatives hold each block's element count fixed and stretch its elements.
+	ImpedanceSensitivities computeSensitivities();
+
+	// Time constants of the slowest thermal modes, found by Lanczos iteration on the meshed model without marching.
+	// Each mode's participation is its share of the monitored block's rise in the transient solve() would run,
+	// from the uniform starting temperature to steady state. Needs a convection boundary, like solveSteady().
+	ThermalModes computeTimeConstants(int modeCount = 5);
+
+	// Solves this stack at each mesh size concurrently, each on a fresh copy meshed under the usual Block rounding,
+	// and estimates every size's discretization error in impedance and block temperatures by Richardson extrapolation.
+	// Block temperature errors are relative to the monitored block's temperature rise. Uses steady solves when a
+	// convection boundary is set; otherwise transient solves, with the time step scaled down by (h / meshSize)^2 on
+	// finer meshes to stay stable. Needs at least two sizes, three to observe the order of convergence.
+	MeshConvergenceReport studyMeshConvergence(std::vector<double> meshSizes, double relativeTolerance = 0.01);
+
+	// Silences all console output, including the default progress line
+	void setQuiet(bool quietIn);
+
+	// Programmatic access for embedding the solver in other programs
+	// step() marches a fixed number of time steps from the current state, with no convergence test or output
+	// getTime() is the simulated time elapsed so far [sec], restarting from zero with each solve()
+	void step(int stepCount);
+	double getTime();
+	int getBlockCount();
+	BlockStatistics getBlockStatistics(int blockIndexIn);
+
+	// Points into the mesh without copying. Empty grid positions read as NaN, see also getElementBlock().
+	// Valid until the stack is re-meshed or destroyed
+	TemperatureField getTemperatureField();
+
+	// Block owning the element at a grid position held by this process, -1 if empty or not held
+	int getElementBlock(int x, int y, int z);
+
+	// Records phase timings, stepping throughput and memory use, written as a JSON report at the end of solve()
+	// Call before mesh() so that the meshing phases are captured
+	void enableInstrumentation(std::string reportPathIn);
+
+	// Looks up solve() and solveSteady() results in an on-disk cache keyed by the stack's configuration, names excluded.
+	// An exact match is reported without solving; solveSteady() warm-starts from a cached field with the same geometry.
+	// Transient runs are only looked up and stored when they start from a uniform startingTemperature. Single process only
+	void enableResultCache(std::string directoryIn);
+
+	// Replaces the default console progress line with a user callback
+	// Called at sample points, no more often than once per minIntervalSeconds of wall-clock time.
+	// Threading: the callback runs on a reporter thread that solve() starts, not on the thread that called solve().
+	// Calls come one at a time, in sample order, and all have returned by the time solve() does. The solver keeps
+	// stepping meanwhile, so the callback must not call into this ThermalStack, and anything it shares with other
+	// threads (UI widgets, non-thread-safe state) must be locked or handed over to the owning thread.
+	void setProgressCallback(ProgressCallback callbackIn, double minIntervalSecondsIn = 0);
+
 private:
 
 	void initElementArray();
@@ -55,14 +218,79 @@ private:
 
 	void genMeshElements();
 
+	void rasterizeLayer(int layer, int zStart);
+
 	std::vector<MeshElement *> findNeighborElements(int x, int y, int z);
 
 	void genMeshNodes();
 
+	double interfaceResistanceBetween(MeshElement * first, MeshElement * second);
+
+	void genMeshBoundaries();
+
+	void refreshBlock(int blockIndexIn);
+
+	std::vector<int> getLayerZElementCounts();
+
+	void remeshKeepingTemperatures(std::vector<int> oldLayerZElementCounts);
+
+	// Frees the elements, links and boundaries and returns the blocks to their unmeshed state
+	void releaseMesh();
+
 	void illustrate();
 
 	int locateTauStep(double tempInitial, double tempSteady);
 
+	void advanceOneStep();
+
+	void indexTemperatureDependentConductances();
+
+	void trackTemperatureDependence(int blockIndexIn);
+
+	int refreshConductances(SteadyStateSolver * system);
+
+	bool canSolveSteady();
+
+	// Temperature thermal impedance is measured from, see solve()
+	double getImpedanceReferenceTemperature();
+
+	void indexSteadyUnknowns();
+
+	SteadyStateSolver assembleSteadySystem();
+
+	int steadyIndexOf(MeshElement * element);
+
+	bool solveSteadyField(SteadyStateSolver & system, std::vector<double> & temperatures);
+
+	// Adds the source stack's blocks, interfaces, boundaries, traces, k(T) tolerance and monitored block to this empty stack
+	void copyStackDefinition(ThermalStack & source);
+
+	// Canonical text of the stack for the result cache: the geometry alone, and everything that affects a solution
+	std::string canonicalGeometry();
+	std::string canonicalConfiguration(bool steady);
+
+	// Active element temperatures in array order; setting fails if the count does not match this mesh
+	std::vector<double> getActiveTemperatures();
+	bool setActiveTemperatures(const std::vector<double> & temperatures);
+
+	bool useCachedResult(bool steady);
+	// True while every active element is still at startingTemperature, i.e. before any solve has moved the field
+	bool isAtStartingTemperature();
+	void storeResult(CachedResult & result);
+
+	void recordMeshFootprint();
+
+	bool ownsLayer(int z);
+
+	bool isFirstProcess();
+
+	void exchangeHalos();
+
+	// Block statistics combined across all processes
+	double globalSum(double value);
+	double getGlobalBulkTemp(int blockIndexIn);
+	double getGlobalTempNonUniformity(int blockIndexIn);
+
 	// Solver and mesh parameters
 	double currTime;
 	double meshSize;
@@ -73,15 +301,63 @@ private:
 	double previousTemperature;
 	int blockIndex;
 	std::vector<double> tempHistory;
+	std::vector<int> tracedBlocks;
+	double traceEndTime;
+
+	// Domain decomposition, the whole stack when running in a single process
+	DomainDecomposition * decomposition;
+	int zOwnedBegin;
+	int zOwnedEnd;
+	int zAllocBegin;	// owned layers plus a one-layer halo on each side
+	int zAllocEnd;
+	std::vector<double> haloSendLower;
+	std::vector<double> haloReceiveLower;
+	std::vector<double> haloSendUpper;
+	std::vector<double> haloReceiveUpper;
+	std::ostream * console;	// discards output on all but the first process, or when quiet
+	std::ostream nullConsole;
+	bool quiet;
+
+	// Instrumentation and progress reporting
+	RunInstrumentation * instrumentation;
+	ResultCache * resultCache;
+	std::string reportPath;
+	ProgressCallback progressCallback;
+	double progressMinIntervalSeconds;
 
 	// 3D object stuff
 	std::vector<Block> blocks;
+	std::vector<std::vector<int> > layerBlocks;	// block indices making up each layer
+	std::vector<double> interfaceResistances;	// [K*mm^2/W] between layer i and layer i + 1
+	std::vector<int> zLayerIndices;				// owning layer of each z-layer of elements
 	int xElementCountMax;
 	int yElementCountMax;
 	int zElementCountMax;
 	int activeElementCount;
 	int totalElementCount;
-	MeshElement * elementArray;
+	MeshElement * elementArray;	// holds z-layers zAllocBegin to zAllocEnd
+	std::vector<double> blockEnergyGenPerTimestep;	// per element of each block [J], set every step from the blocks' power
 	std::vector<MeshNode> nodeVector;
+
+	// Convection boundaries, h of zero means adiabatic
+	double hBottom, ambientBottom;
+	double hTop, ambientTop;
+	double hSides, ambientSides;
+	std::vector<MeshBoundary> boundaryVector;
+
+	// k(T) bookkeeping, empty unless some block's material has a k(T) table
+	std::vector<int> temperatureDependentBlocks;
+	std::vector<double> conductanceTemperatures;	// per elementArray entry, temperature its conductances were computed at
+	std::vector<char> elementRefreshed;			// per elementArray entry, set between an element refresh and its links'
+	double conductanceTolerance;
+
+	// Elements (halos included), links and boundaries touching each block, so an edited block only revisits its own
+	std::vector<std::vector<int> > blockElementIndices;	// into elementArray
+	std::vector<std::vector<int> > blockNodeIndices;
+	std::vector<std::vector<int> > blockBoundaryIndices;
+
+	// Steady-state unknown numbering over the active elements, -1 for empty coordinates
+	std::vector<int> steadyIndices;
+	std::vector<MeshElement *> steadyUnknowns;
 };
 
@@ -0,0 +1,286 @@
+// C interface to ThermalStack, see ThermalStackC.h
+
+#include "ThermalStackC.h"
+#include "ThermalStack.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+struct thermalstack {
+	ThermalStack stack;
+
+	thermalstack(double meshSize, double timeStep, int sampleIntervalSteps, double threshold, double startingTemperature)
+		: stack(meshSize, timeStep, sampleIntervalSteps, threshold, startingTemperature) {}
+};
+
+// Runs a call against a valid stack, turning a null handle or an exception into -1
+template <typename Call>
+static int guarded(thermalstack * handle, Call call)
+{
+	if (handle == nullptr) {
+		return -1;
+	}
+
+	try {
+		return call(handle->stack);
+	}
+	catch (...) {
+		return -1;
+	}
+}
+
+static bool isBlock(ThermalStack & stack, int block)
+{
+	return block >= 0 && block < stack.getBlockCount();
+}
+
+thermalstack * thermalstack_create(double mesh_size,
+								   double time_step,
+								   int sample_interval_steps,
+								   double delta_t_convergence_threshold,
+								   double starting_temperature)
+{
+	if (mesh_size <= 0 || time_step <= 0 || sample_interval_steps <= 0) {
+		return nullptr;
+	}
+
+	try {
+		return new thermalstack(mesh_size, time_step, sample_interval_steps, delta_t_convergence_threshold, starting_temperature);
+	}
+	catch (...) {
+		return nullptr;
+	}
+}
+
+void thermalstack_destroy(thermalstack * stack)
+{
+	delete stack;
+}
+
+void thermalstack_set_quiet(thermalstack * stack, int quiet)
+{
+	guarded(stack, [&](ThermalStack & s) {
+		s.setQuiet(quiet != 0);
+		return 0;
+	});
+}
+
+int thermalstack_add_block(thermalstack * stack,
+						   double x, double y, double z,
+						   double x_offset, double y_offset,
+						   double k, double c, const char * material_name,
+						   double q_gen)
+{
+	return guarded(stack, [&](ThermalStack & s) {
+		Material material(k, c, material_name != nullptr ? material_name : "");
+		s.addBlock(x, y, z, x_offset, y_offset, material, q_gen);
+		return s.getBlockCount() - 1;
+	});
+}
+
+int thermalstack_add_block_to_layer(thermalstack * stack,
+									double x, double y,
+									double x_offset, double y_offset,
+									double k, double c, const char * material_name,
+									double q_gen)
+{
+	return guarded(stack, [&](ThermalStack & s) {
+		int blockCount = s.getBlockCount();
+		Material material(k, c, material_name != nullptr ? material_name : "");
+		s.addBlockToLayer(x, y, x_offset, y_offset, material, q_gen);
+		return s.getBlockCount() > blockCount ? blockCount : -1;
+	});
+}
+
+int thermalstack_add_interface(thermalstack * stack, double resistance_areal)
+{
+	return guarded(stack, [&](ThermalStack & s) {
+		if (s.getBlockCount() == 0) {
+			return -1;
+		}
+		s.addInterface(resistance_areal);
+		return 0;
+	});
+}
+
+int thermalstack_set_convection_bottom(thermalstack * stack, double h, double ambient_temperature)
+{
+	return guarded(stack, [&](ThermalStack & s) {
+		s.setConvectionBottom(h, ambient_temperature);
+		return 0;
+	});
+}
+
+int thermalstack_set_convection_top(thermalstack * stack, double h, double ambient_temperature)
+{
+	return guarded(stack, [&](ThermalStack & s) {
+		s.setConvectionTop(h, ambient_temperature);
+		return 0;
+	});
+}
+
+int thermalstack_set_convection_sides(thermalstack * stack, double h, double ambient_temperature)
+{
+	return guarded(stack, [&](ThermalStack & s) {
+		s.setConvectionSides(h, ambient_temperature);
+		return 0;
+	});
+}
+
+int thermalstack_set_block_power(thermalstack * stack, int block, double q_gen)
+{
+	return guarded(stack, [&](ThermalStack & s) {
+		if (!isBlock(s, block)) {
+			return -1;
+		}
+		s.setBlockPower(block, q_gen);
+		return 0;
+	});
+}
+
+int thermalstack_set_block_conductivity_table(thermalstack * stack, int block,
+											  const double * temperatures, const double * k, int count)
+{
+	return guarded(stack, [&](ThermalStack & s) {
+		if (!isBlock(s, block) || temperatures == nullptr || k == nullptr || count < 2) {
+			return -1;
+		}
+
+		Material current = s.getBlockMaterial(block);
+		Material tabulated(std::vector<double>(temperatures, temperatures + count),
+						   std::vector<double>(k, k + count),
+						   current.c, current.name);
+		if (!tabulated.isTemperatureDependent()) {
+			return -1;
+		}
+
+		s.setBlockMaterial(block, tabulated);
+		return 0;
+	});
+}
+
+int thermalstack_set_block_power_trace(thermalstack * stack, int block, const char * trace_path)
+{
+	return guarded(stack, [&](ThermalStack & s) {
+		if (!isBlock(s, block) || trace_path == nullptr || !std::ifstream(trace_path).good()) {
+			return -1;
+		}
+		s.setBlockPowerTrace(block, trace_path);
+		return 0;
+	});
+}
+
+int thermalstack_mesh(thermalstack * stack)
+{
+	return guarded(stack, [&](ThermalStack & s) {
+		if (s.isMeshed() || s.getBlockCount() == 0) {
+			return -1;
+		}
+		s.mesh();
+		return 0;
+	});
+}
+
+int thermalstack_monitor_block(thermalstack * stack, int block)
+{
+	return guarded(stack, [&](ThermalStack & s) {
+		if (!isBlock(s, block)) {
+			return -1;
+		}
+		s.monitorBlock(block);
+		return 0;
+	});
+}
+
+int thermalstack_step(thermalstack * stack, int step_count)
+{
+	return guarded(stack, [&](ThermalStack & s) {
+		if (step_count < 0 || s.getTemperatureField().temperature == nullptr) {
+			return -1;
+		}
+		s.step(step_count);
+		return 0;
+	});
+}
+
+int thermalstack_solve(thermalstack * stack)
+{
+	return guarded(stack, [&](ThermalStack & s) {
+		if (s.getTemperatureField().temperature == nullptr) {
+			return -1;
+		}
+		s.solve();
+		return 0;
+	});
+}
+
+int thermalstack_solve_steady(thermalstack * stack)
+{
+	return guarded(stack, [&](ThermalStack & s) {
+		if (s.getTemperatureField().temperature == nullptr) {
+			return -1;
+		}
+		s.solveSteady();
+		return 0;
+	});
+}
+
+double thermalstack_get_time(thermalstack * stack)
+{
+	if (stack == nullptr) {
+		return 0;
+	}
+	return stack->stack.getTime();
+}
+
+int thermalstack_get_block_count(thermalstack * stack)
+{
+	return guarded(stack, [&](ThermalStack & s) {
+		return s.getBlockCount();
+	});
+}
+
+int thermalstack_get_block_stats(thermalstack * stack, int block, thermalstack_block_stats * stats)
+{
+	return guarded(stack, [&](ThermalStack & s) {
+		if (!isBlock(s, block) || stats == nullptr) {
+			return -1;
+		}
+
+		BlockStatistics statistics = s.getBlockStatistics(block);
+		stats->mean_temperature = statistics.meanTemperature;
+		stats->min_temperature = statistics.minTemperature;
+		stats->max_temperature = statistics.maxTemperature;
+		stats->q_gen = statistics.qGen;
+		return 0;
+	});
+}
+
+thermalstack_field thermalstack_get_temperature_field(thermalstack * stack)
+{
+	thermalstack_field view = { nullptr, 0, 0, 0, 0, 0 };
+
+	if (stack == nullptr) {
+		return view;
+	}
+
+	TemperatureField field = stack->stack.getTemperatureField();
+	if (field.temperature == nullptr) {
+		return view;
+	}
+
+	view.temperature = field.temperature;
+	view.stride = field.stride;
+	view.x_count = field.xCount;
+	view.y_count = field.yCount;
+	view.z_count = field.zCount;
+	view.z_begin = field.zBegin;
+	return view;
+}
+
+int thermalstack_get_element_block(thermalstack * stack, int x, int y, int z)
+{
+	return guarded(stack, [&](ThermalStack & s) {
+		return s.getElementBlock(x, y, z);
+	});
+}
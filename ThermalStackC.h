@@ -0,0 +1,124 @@
+/* C interface to ThermalStack, for embedding the solver in other programs through a shared library.
+ * Mirrors the C++ API: create a stack, add blocks and boundaries, mesh, then step or solve and read results back.
+ * Units are those of ThermalStack: mm, W, C, sec, k in W/mmK, c in J/mm^3K, h in W/mm^2K.
+ *
+ * Calls returning int give 0 on success and -1 on a bad argument or failure, unless noted otherwise.
+ * No C++ exception crosses this interface.
+ *
+ * Example Usage:
+ *
+ *		thermalstack * stack = thermalstack_create(0.5, 0.0001, 10, 0.00001, 65);
+ *		thermalstack_add_block(stack, 10, 10, 1, 0, 0, 0.148, 0.001643, "Silicon", 100);
+ *		thermalstack_set_convection_bottom(stack, 0.04, 65);
+ *		thermalstack_mesh(stack);
+ *		thermalstack_step(stack, 1000);
+ *		thermalstack_field field = thermalstack_get_temperature_field(stack);
+ *		thermalstack_destroy(stack);
+ */
+
+#pragma once
+#include <stddef.h>
+
+#if defined(_WIN32)
+#if defined(THERMALSTACK_EXPORTS)
+#define THERMALSTACK_API __declspec(dllexport)
+#else
+#define THERMALSTACK_API __declspec(dllimport)
+#endif
+#elif defined(__GNUC__)
+#define THERMALSTACK_API __attribute__((visibility("default")))
+#else
+#define THERMALSTACK_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct thermalstack thermalstack;
+
+typedef struct thermalstack_block_stats {
+	double mean_temperature;	/* [C] */
+	double min_temperature;		/* [C] */
+	double max_temperature;		/* [C] */
+	double q_gen;				/* [W] */
+} thermalstack_block_stats;
+
+/* Read-only view of the element temperatures, pointing into the mesh itself.
+ * Element (x, y, z) is at (const char *)temperature + stride * (x + x_count * (y + y_count * (z - z_begin))).
+ * Empty grid positions read as NaN. Valid until the stack is re-meshed or destroyed. */
+typedef struct thermalstack_field {
+	const double * temperature;
+	size_t stride;				/* bytes between consecutive elements */
+	int x_count;
+	int y_count;
+	int z_count;				/* z-layers held by this process */
+	int z_begin;				/* global index of the first held z-layer, 0 unless decomposed */
+} thermalstack_field;
+
+/* NULL if the stack could not be created */
+THERMALSTACK_API thermalstack * thermalstack_create(double mesh_size,
+													 double time_step,
+													 int sample_interval_steps,
+													 double delta_t_convergence_threshold,
+													 double starting_temperature);
+
+THERMALSTACK_API void thermalstack_destroy(thermalstack * stack);
+
+/* Discards all console output from this stack */
+THERMALSTACK_API void thermalstack_set_quiet(thermalstack * stack, int quiet);
+
+/* Both return the new block's index, or -1. The first starts a new layer, the second joins the top layer */
+THERMALSTACK_API int thermalstack_add_block(thermalstack * stack,
+											double x, double y, double z,
+											double x_offset, double y_offset,
+											double k, double c, const char * material_name,
+											double q_gen);
+
+THERMALSTACK_API int thermalstack_add_block_to_layer(thermalstack * stack,
+													 double x, double y,
+													 double x_offset, double y_offset,
+													 double k, double c, const char * material_name,
+													 double q_gen);
+
+/* Contact resistance on top of the most recently added layer [K*mm^2/W] */
+THERMALSTACK_API int thermalstack_add_interface(thermalstack * stack, double resistance_areal);
+
+THERMALSTACK_API int thermalstack_set_convection_bottom(thermalstack * stack, double h, double ambient_temperature);
+THERMALSTACK_API int thermalstack_set_convection_top(thermalstack * stack, double h, double ambient_temperature);
+THERMALSTACK_API int thermalstack_set_convection_sides(thermalstack * stack, double h, double ambient_temperature);
+
+THERMALSTACK_API int thermalstack_set_block_power(thermalstack * stack, int block, double q_gen);
+
+/* Replaces a block's constant k with a k(T) table of count points, temperatures increasing [C], k [W/mmK] */
+THERMALSTACK_API int thermalstack_set_block_conductivity_table(thermalstack * stack, int block,
+															   const double * temperatures, const double * k, int count);
+
+THERMALSTACK_API int thermalstack_set_block_power_trace(thermalstack * stack, int block, const char * trace_path);
+
+/* Once per stack, a second call returns -1 */
+THERMALSTACK_API int thermalstack_mesh(thermalstack * stack);
+THERMALSTACK_API int thermalstack_monitor_block(thermalstack * stack, int block);
+
+/* Marches step_count time steps from the current state, without a convergence test */
+THERMALSTACK_API int thermalstack_step(thermalstack * stack, int step_count);
+
+/* March to convergence, or solve for the steady state directly, as ThermalStack::solve() and solveSteady() */
+THERMALSTACK_API int thermalstack_solve(thermalstack * stack);
+THERMALSTACK_API int thermalstack_solve_steady(thermalstack * stack);
+
+/* Simulated time elapsed [sec], zero before the first step */
+THERMALSTACK_API double thermalstack_get_time(thermalstack * stack);
+
+THERMALSTACK_API int thermalstack_get_block_count(thermalstack * stack);
+THERMALSTACK_API int thermalstack_get_block_stats(thermalstack * stack, int block, thermalstack_block_stats * stats);
+
+/* All zero with a NULL pointer before meshing */
+THERMALSTACK_API thermalstack_field thermalstack_get_temperature_field(thermalstack * stack);
+
+/* Block owning the element at (x, y, z), -1 if empty or not held by this process */
+THERMALSTACK_API int thermalstack_get_element_block(thermalstack * stack, int x, int y, int z);
+
+#ifdef __cplusplus
+}
+#endif
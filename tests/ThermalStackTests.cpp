@@ -0,0 +1,973 @@
+// Regression tests for ThermalStack, no test framework needed. From the repository root:
+//
+//		g++ -std=c++11 -O2 -pthread -I. -o ThermalStackTests tests/ThermalStackTests.cpp $(ls *.cpp | grep -v Main.cpp)
+//		./ThermalStackTests
+//
+// Prints each failed check and exits non-zero if there were any.
+
+#include "ThermalStack.h"
+#include "Material.h"
+#include "ThermalStackC.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+
+static int failureCount = 0;
+
+static void check(bool passed, const char * expression, const char * file, int line)
+{
+	if (!passed) {
+		std::cerr << file << ":" << line << ": check failed: " << expression << std::endl;
+		failureCount++;
+	}
+}
+
+#define CHECK(condition) check((condition), #condition, __FILE__, __LINE__)
+
+static bool isClose(double actual, double expected, double relativeTolerance)
+{
+	return fabs(actual - expected) <= relativeTolerance * fabs(expected);
+}
+
+// Runs a call with std::cout captured and returns what it printed
+template <typename Call>
+static std::string captureOutput(Call call)
+{
+	std::ostringstream captured;
+	std::streambuf * original = std::cout.rdbuf(captured.rdbuf());
+	call();
+	std::cout.rdbuf(original);
+	return captured.str();
+}
+
+// Last thermal impedance printed by solve() or solveSteady(), NaN if none
+static double reportedImpedance(const std::string & output)
+{
+	const std::string label = "Thermal impedance, heat source to infinite heatsink = ";
+	size_t at = output.rfind(label);
+	if (at == std::string::npos) {
+		return NAN;
+	}
+	return atof(output.c_str() + at + label.size());
+}
+
+static Material copper(0.401, 0.003450, "Copper");
+static Material silicon(0.148, 0.001643, "Silicon");
+
+// A die on a water-cooled copper spreader, monitored at the die
+static void buildSpreader(ThermalStack & stack, double ambientTemperature)
+{
+	stack.addBlock(10, 10, 2, copper, 0);
+	stack.addBlock(4, 4, 1, silicon, 10);
+	stack.setConvectionBottom(0.04, ambientTemperature);
+	stack.monitorBlock(1);
+}
+
+// Z is measured from the convection ambient, so the starting temperature must not move it
+static void testSteadyImpedanceIgnoresStartingTemperature()
+{
+	double impedances[2];
+	double sensitivityImpedances[2];
+	double startingTemperatures[2] = { 65, 25 };
+
+	for (int i = 0; i < 2; i++) {
+		ThermalStack stack(1, 0.0002, 10, 0.00001, startingTemperatures[i]);
+		buildSpreader(stack, 65);
+		captureOutput([&]() { stack.mesh(); });
+
+		impedances[i] = reportedImpedance(captureOutput([&]() { stack.solveSteady(); }));
+		captureOutput([&]() { sensitivityImpedances[i] = stack.computeSensitivities().thermalImpedance; });
+	}
+
+	CHECK(isClose(impedances[1], impedances[0], 1e-3));
+	CHECK(isClose(sensitivityImpedances[1], sensitivityImpedances[0], 1e-6));
+	CHECK(isClose(sensitivityImpedances[0], impedances[0], 1e-3));
+}
+
+// A transient started below the ambient must still report Z from the ambient, matching the steady solve
+static void testTransientImpedanceFromAmbient()
+{
+	ThermalStack steadyStack(1, 0.0002, 10, 0.00001, 65);
+	buildSpreader(steadyStack, 65);
+	captureOutput([&]() { steadyStack.mesh(); });
+	double steadyImpedance = reportedImpedance(captureOutput([&]() { steadyStack.solveSteady(); }));
+
+	ThermalStack transientStack(1, 0.0002, 10, 0.00001, 25);
+	buildSpreader(transientStack, 65);
+	transientStack.setProgressCallback(ProgressCallback());
+	captureOutput([&]() { transientStack.mesh(); });
+	double transientImpedance = reportedImpedance(captureOutput([&]() { transientStack.solve(); }));
+
+	CHECK(isClose(transientImpedance, steadyImpedance, 0.01));
+}
+
+// Active element count printed by mesh()
+static int reportedElementCount(const std::string & output)
+{
+	const std::string label = "Generated ";
+	size_t at = output.rfind(label);
+	if (at == std::string::npos) {
+		return -1;
+	}
+	return atoi(output.c_str() + at + label.size());
+}
+
+// Each study run must solve the same stack as a direct solve at that mesh size, non-square blocks included
+static void testMeshStudyMatchesDirectSolve()
+{
+	ThermalStack studied(2, 0.0002, 10, 0.00001, 25);
+	studied.addBlock(12, 6, 2, copper, 0);
+	studied.addBlock(4, 2, 1, silicon, 10);
+	studied.setConvectionBottom(0.04, 65);
+	studied.monitorBlock(1);
+
+	MeshConvergenceReport report;
+	captureOutput([&]() { report = studied.studyMeshConvergence({ 2, 1 }); });
+
+	ThermalStack direct(1, 0.0002, 10, 0.00001, 25);
+	direct.addBlock(12, 6, 2, copper, 0);
+	direct.addBlock(4, 2, 1, silicon, 10);
+	direct.setConvectionBottom(0.04, 65);
+	direct.monitorBlock(1);
+	int directElementCount = reportedElementCount(captureOutput([&]() { direct.mesh(); }));
+	double directImpedance = reportedImpedance(captureOutput([&]() { direct.solveSteady(); }));
+
+	CHECK(report.meshSizes.size() == 2 && report.meshSizes[1] == 1);
+	CHECK(report.elementCounts[1] == directElementCount);
+	CHECK(isClose(report.thermalImpedances[1], directImpedance, 1e-3));
+}
+
+// Die on a spreader with every geometry field open to variation
+struct SpreaderGeometry {
+	double meshSize;
+	double x, y, z;
+	double dieXOffset, dieYOffset;
+};
+
+// True if solveSteady() reported this stack straight from the cache
+static bool solvesFromCache(const SpreaderGeometry & geometry, const std::string & cacheDirectory)
+{
+	ThermalStack stack(geometry.meshSize, 0.0002, 10, 0.00001, 65);
+	stack.addBlock(geometry.x, geometry.y, geometry.z, copper, 0);
+	stack.addBlock(4, 4, 1, geometry.dieXOffset, geometry.dieYOffset, silicon, 10);
+	stack.setConvectionBottom(0.04, 65);
+	stack.monitorBlock(1);
+	stack.enableResultCache(cacheDirectory);
+
+	std::string output = captureOutput([&]() {
+		stack.mesh();
+		stack.solveSteady();
+	});
+	return output.find("Found this configuration in the result cache") != std::string::npos;
+}
+
+// Changing any one geometry field must miss the cache, even where the element counts stay the same
+static void testCacheKeyCoversGeometry()
+{
+	char cacheDirectory[] = "/tmp/ThermalStackTestsXXXXXX";
+	if (mkdtemp(cacheDirectory) == nullptr) {
+		CHECK(!"could not create a cache directory");
+		return;
+	}
+
+	SpreaderGeometry base = { 4, 10, 10, 2, 0, 0 };
+	solvesFromCache(base, cacheDirectory);
+	CHECK(solvesFromCache(base, cacheDirectory));
+
+	SpreaderGeometry variants[6] = { base, base, base, base, base, base };
+	variants[0].meshSize = 3.9;
+	variants[1].x = 11;
+	variants[2].y = 11;
+	variants[3].z = 2.5;
+	variants[4].dieXOffset = 1;
+	variants[5].dieYOffset = 1;
+
+	for (int i = 0; i < 6; i++) {
+		if (solvesFromCache(variants[i], cacheDirectory)) {
+			std::cerr << "geometry variant " << i << " was served from the cache" << std::endl;
+			failureCount++;
+		}
+	}
+}
+
+// Time and monitored temperature on the last line solve() printed with this marker, e.g. "one time constant"
+static bool reportedMarker(const std::string & output, const std::string & marker, double & time, double & temperature)
+{
+	size_t markerAt = output.rfind("<- @ " + marker);
+	if (markerAt == std::string::npos) {
+		return false;
+	}
+	size_t timeAt = output.rfind("t = ", markerAt);
+	size_t temperatureAt = output.rfind("T_avg = ", markerAt);
+	if (timeAt == std::string::npos || temperatureAt == std::string::npos) {
+		return false;
+	}
+	time = atof(output.c_str() + timeAt + 4);
+	temperature = atof(output.c_str() + temperatureAt + 8);
+	return true;
+}
+
+// A cached transient must not change a later transient's time constant: a run at a different power may not be
+// warm-started from it, and a run that started from a warm field may not be stored
+static void testTransientCacheNeedsColdStart()
+{
+	char cacheDirectory[] = "/tmp/ThermalStackTestsXXXXXX";
+	if (mkdtemp(cacheDirectory) == nullptr) {
+		CHECK(!"could not create a cache directory");
+		return;
+	}
+
+	double coldTime[3], coldTemperature[3];
+	double settledTime[3], settledTemperature[3];
+
+	// cold and uncached; after a 10 W run is cached; after a warm re-solve may have been cached
+	for (int run = 0; run < 3; run++) {
+		ThermalStack stack(1, 0.0002, 10, 0.00001, 65);
+		buildSpreader(stack, 65);
+		stack.setBlockPower(1, 20);
+		stack.setProgressCallback(ProgressCallback());
+		if (run > 0) {
+			stack.enableResultCache(cacheDirectory);
+		}
+
+		if (run == 1) {
+			ThermalStack cached(1, 0.0002, 10, 0.00001, 65);
+			buildSpreader(cached, 65);
+			cached.setProgressCallback(ProgressCallback());
+			cached.enableResultCache(cacheDirectory);
+			captureOutput([&]() {
+				cached.mesh();
+				cached.solve();
+			});
+		}
+		if (run == 2) {
+			ThermalStack warm(1, 0.0002, 10, 0.00001, 65);
+			buildSpreader(warm, 65);
+			warm.setBlockPower(1, 20);
+			warm.setProgressCallback(ProgressCallback());
+			warm.enableResultCache(cacheDirectory);
+			captureOutput([&]() {
+				warm.mesh();
+				warm.solveSteady();
+				warm.setBlockPower(1, 15);
+				warm.setBlockPower(1, 20);
+				warm.solve();
+			});
+		}
+
+		std::string output = captureOutput([&]() {
+			stack.mesh();
+			stack.solve();
+		});
+		CHECK(reportedMarker(output, "one time constant", coldTime[run], coldTemperature[run]));
+		CHECK(reportedMarker(output, "steady state", settledTime[run], settledTemperature[run]));
+		if (run == 1) {
+			CHECK(output.find("Found this configuration in the result cache") == std::string::npos);
+		}
+	}
+
+	for (int run = 1; run < 3; run++) {
+		CHECK(isClose(coldTime[run], coldTime[0], 1e-9));
+		CHECK(isClose(coldTemperature[run], coldTemperature[0], 1e-9));
+		CHECK(isClose(settledTime[run], settledTime[0], 1e-9));
+	}
+}
+
+// A power log rewritten in place, with the same path and end time, must miss the cache
+static void testTraceEditedInPlaceMissesCache()
+{
+	char cacheDirectory[] = "/tmp/ThermalStackTestsXXXXXX";
+	char tracePath[] = "/tmp/ThermalStackTestsTraceXXXXXX";
+	int traceFile = mkstemp(tracePath);
+	if (mkdtemp(cacheDirectory) == nullptr || traceFile < 0) {
+		CHECK(!"could not create a cache directory and trace file");
+		return;
+	}
+	close(traceFile);
+
+	const char * traces[3] = { "0, 10\n1, 10\n", "0, 20\n1, 20\n", "0, 20\n1, 20\n" };
+	bool fromCache[3];
+
+	for (int run = 0; run < 3; run++) {
+		std::ofstream(tracePath) << traces[run];
+
+		ThermalStack stack(1, 0.0002, 10, 0.00001, 65);
+		buildSpreader(stack, 65);
+		stack.setProgressCallback(ProgressCallback());
+		stack.setBlockPowerTrace(1, tracePath);
+		stack.enableResultCache(cacheDirectory);
+
+		std::string output = captureOutput([&]() {
+			stack.mesh();
+			stack.solve();
+		});
+		fromCache[run] = output.find("Found this configuration in the result cache") != std::string::npos;
+	}
+
+	remove(tracePath);
+
+	CHECK(!fromCache[1]);
+	CHECK(fromCache[2]);
+}
+
+// A trace attached after mesh() must drive the elements from the first step, as one attached before does
+static void testPowerTraceAttachedAfterMesh()
+{
+	char tracePath[] = "/tmp/ThermalStackTestsTraceXXXXXX";
+	int traceFile = mkstemp(tracePath);
+	if (traceFile < 0) {
+		CHECK(!"could not create a trace file");
+		return;
+	}
+	close(traceFile);
+	std::ofstream(tracePath) << "0, 10\n1, 10\n";
+
+	double dieTemperatures[2];
+
+	for (int attachAfterMesh = 0; attachAfterMesh < 2; attachAfterMesh++) {
+		ThermalStack stack(1, 0.0002, 10, 0.00001, 65);
+		stack.addBlock(10, 10, 2, copper, 0);
+		stack.addBlock(4, 4, 1, silicon, 0);
+		stack.setConvectionBottom(0.04, 65);
+		stack.monitorBlock(1);
+
+		captureOutput([&]() {
+			if (!attachAfterMesh) stack.setBlockPowerTrace(1, tracePath);
+			stack.mesh();
+			if (attachAfterMesh) stack.setBlockPowerTrace(1, tracePath);
+			stack.step(2000);
+		});
+		dieTemperatures[attachAfterMesh] = stack.getBlockStatistics(1).meanTemperature;
+	}
+
+	remove(tracePath);
+
+	CHECK(dieTemperatures[0] > 66);
+	CHECK(isClose(dieTemperatures[1], dieTemperatures[0], 1e-9));
+}
+
+// Stands in for one rank of a decomposition; collectives are left to the identity, as on a lone process
+class StubDecomposition : public DomainDecomposition
+{
+
+public:
+
+	StubDecomposition(int rankIn, int rankCountIn) : rank(rankIn), rankCount(rankCountIn) {}
+
+	int getRank() { return rank; }
+	int getRankCount() { return rankCount; }
+	void exchangeHalo(double *, double *, double *, double *, int) {}
+	void sum(double *, int) {}
+	void min(double *, int) {}
+	void max(double *, int) {}
+
+private:
+
+	int rank;
+	int rankCount;
+};
+
+// More processes than z-layers is refused on every rank before anything is allocated
+static void testDecompositionNeedsALayerPerProcess()
+{
+	for (int rank = 0; rank < 4; rank++) {
+		StubDecomposition decomposition(rank, 4);
+		ThermalStack stack(1, 0.0002, 10, 0.00001, 65);
+		stack.addBlock(10, 10, 1, copper, 0);
+		stack.addBlock(4, 4, 1, silicon, 10);
+		stack.decompose(&decomposition);
+
+		bool refused = false;
+		captureOutput([&]() {
+			try {
+				stack.mesh();
+			}
+			catch (const std::runtime_error &) {
+				refused = true;
+			}
+		});
+
+		CHECK(refused);
+		CHECK(stack.getTemperatureField().temperature == nullptr);
+	}
+
+	StubDecomposition decomposition(0, 2);
+	ThermalStack stack(1, 0.0002, 10, 0.00001, 65);
+	stack.addBlock(10, 10, 1, copper, 0);
+	stack.addBlock(4, 4, 1, silicon, 10);
+	stack.decompose(&decomposition);
+	captureOutput([&]() { stack.mesh(); });
+	CHECK(stack.getTemperatureField().temperature != nullptr);
+}
+
+// The C API meshes a stack once and refuses a second call instead of crashing
+static void testCApiMeshesOnce()
+{
+	thermalstack * stack = thermalstack_create(1, 0.0002, 10, 0.00001, 65);
+	thermalstack_set_quiet(stack, 1);
+	thermalstack_add_block(stack, 10, 10, 2, 0, 0, copper.k, copper.c, "Copper", 0);
+	thermalstack_add_block(stack, 4, 4, 1, 0, 0, silicon.k, silicon.c, "Silicon", 10);
+	thermalstack_set_convection_bottom(stack, 0.04, 65);
+
+	CHECK(thermalstack_mesh(stack) == 0);
+	CHECK(thermalstack_mesh(stack) == -1);
+	CHECK(thermalstack_step(stack, 10) == 0);
+
+	thermalstack_destroy(stack);
+}
+
+// Time reads zero before stepping and advances exactly one time step per step
+static void testCApiTimeIsElapsedTime()
+{
+	thermalstack * stack = thermalstack_create(1, 0.0001, 10, 0.00001, 65);
+	thermalstack_set_quiet(stack, 1);
+	thermalstack_add_block(stack, 10, 10, 2, 0, 0, copper.k, copper.c, "Copper", 10);
+	thermalstack_set_convection_bottom(stack, 0.04, 65);
+	thermalstack_mesh(stack);
+
+	CHECK(thermalstack_get_time(stack) == 0);
+	thermalstack_step(stack, 100);
+	CHECK(isClose(thermalstack_get_time(stack), 0.01, 1e-9));
+
+	thermalstack_destroy(stack);
+}
+
+// Overlapping blocks in a layer: the block added first keeps the overlap, and no block's power is lost
+static void testOverlapKeepsFirstBlockAndConservesPower()
+{
+	const double timeStep = 0.0002;
+	const int stepCount = 200;
+
+	// adiabatic, so every joule generated stays in the stack
+	ThermalStack stack(1, timeStep, 10, 0.00001, 25);
+	stack.addBlock(12, 4, 1, copper, 0);
+	stack.addBlock(4, 4, 1, 0, 0, silicon, 10);			// block 1, x elements 4 to 7
+	stack.addBlockToLayer(4, 4, -2, 0, silicon, 10);	// block 2, x elements 2 to 5
+	captureOutput([&]() {
+		stack.mesh();
+		stack.step(stepCount);
+	});
+
+	CHECK(stack.getElementBlock(4, 1, 1) == 1);
+	CHECK(stack.getElementBlock(5, 1, 1) == 1);
+	CHECK(stack.getElementBlock(3, 1, 1) == 2);
+
+	// 1 mm cubes, so each element holds c * (T - T_start) joules
+	TemperatureField field = stack.getTemperatureField();
+	double storedEnergy = 0;
+	for (int z = 0; z < field.zCount; z++) {
+		for (int y = 0; y < field.yCount; y++) {
+			for (int x = 0; x < field.xCount; x++) {
+				int block = stack.getElementBlock(x, y, z);
+				if (block < 0) {
+					continue;
+				}
+				const char * element = (const char *)field.temperature + field.stride * (x + field.xCount * (y + field.yCount * z));
+				storedEnergy += stack.getBlockMaterial(block).c * (*(const double *)element - 25);
+			}
+		}
+	}
+
+	CHECK(isClose(storedEnergy, 20 * stepCount * timeStep, 1e-9));
+}
+
+// Steady Z through computeSensitivities(), with its output captured
+static double steadyImpedance(ThermalStack & stack)
+{
+	double impedance = 0;
+	captureOutput([&]() { impedance = stack.computeSensitivities().thermalImpedance; });
+	return impedance;
+}
+
+// Giving a meshed block a k(T) table, or taking it away, must match a stack built that way from the start
+static void testConductivityTableEditsAfterMesh()
+{
+	Material tabulatedSilicon({ 25, 75, 125, 175 }, { 0.148, 0.119, 0.098, 0.083 }, silicon.c, "Silicon");
+
+	ThermalStack tabulated(1, 0.0002, 10, 0.00001, 65);
+	tabulated.addBlock(10, 10, 2, copper, 0);
+	tabulated.addBlock(4, 4, 1, tabulatedSilicon, 20);
+	tabulated.setConvectionBottom(0.04, 65);
+	tabulated.monitorBlock(1);
+	captureOutput([&]() { tabulated.mesh(); });
+	double tabulatedImpedance = steadyImpedance(tabulated);
+
+	ThermalStack constant(1, 0.0002, 10, 0.00001, 65);
+	buildSpreader(constant, 65);
+	constant.setBlockPower(1, 20);
+	captureOutput([&]() { constant.mesh(); });
+	double constantImpedance = steadyImpedance(constant);
+
+	ThermalStack edited(1, 0.0002, 10, 0.00001, 65);
+	buildSpreader(edited, 65);
+	edited.setBlockPower(1, 20);
+	captureOutput([&]() { edited.mesh(); });
+	steadyImpedance(edited);
+
+	edited.setBlockMaterial(1, tabulatedSilicon);
+	CHECK(isClose(steadyImpedance(edited), tabulatedImpedance, 1e-4));
+
+	edited.setBlockMaterial(1, silicon);
+	CHECK(isClose(steadyImpedance(edited), constantImpedance, 1e-6));
+
+	CHECK(tabulatedImpedance > constantImpedance * 1.01);
+}
+
+// A study must refuse a monitored block without power, and solve its copies with the stack's k(T) tolerance
+static void testMeshStudyChecksMonitoredBlockAndTolerance()
+{
+	ThermalStack unpowered(1, 0.0002, 10, 0.00001, 65);
+	buildSpreader(unpowered, 65);
+	unpowered.monitorBlock(0);
+
+	MeshConvergenceReport refused;
+	captureOutput([&]() { refused = unpowered.studyMeshConvergence({ 2, 1 }); });
+	CHECK(refused.meshSizes.empty());
+	CHECK(refused.recommendedMeshSize == 0);
+
+	Material tabulatedSilicon({ 25, 75, 125, 175 }, { 0.148, 0.119, 0.098, 0.083 }, silicon.c, "Silicon");
+
+	ThermalStack studied(2, 0.0002, 10, 0.00001, 65);
+	studied.addBlock(10, 10, 2, copper, 0);
+	studied.addBlock(4, 4, 1, tabulatedSilicon, 20);
+	studied.setConvectionBottom(0.04, 65);
+	studied.monitorBlock(1);
+	studied.setConductanceTolerance(1000);
+
+	MeshConvergenceReport report;
+	captureOutput([&]() { report = studied.studyMeshConvergence({ 2, 1 }); });
+
+	double impedances[2];
+	double tolerances[2] = { 1000, 0.1 };
+
+	for (int i = 0; i < 2; i++) {
+		ThermalStack direct(1, 0.0002, 10, 0.00001, 65);
+		direct.addBlock(10, 10, 2, copper, 0);
+		direct.addBlock(4, 4, 1, tabulatedSilicon, 20);
+		direct.setConvectionBottom(0.04, 65);
+		direct.monitorBlock(1);
+		direct.setConductanceTolerance(tolerances[i]);
+		captureOutput([&]() { direct.mesh(); });
+		impedances[i] = steadyImpedance(direct);
+	}
+
+	CHECK(report.thermalImpedances.size() == 2);
+	CHECK(!isClose(impedances[0], impedances[1], 1e-3));
+	CHECK(report.thermalImpedances.size() == 2 && isClose(report.thermalImpedances[1], impedances[0], 1e-4));
+}
+
+// Spreader and die with a bonded interface, every parameter open to perturbation
+struct BondedStack {
+	double kSpreader, kDie;
+	double zSpreader, zDie;
+	double interfaceResistance;
+};
+
+static double bondedImpedance(const BondedStack & parameters, ImpedanceSensitivities * sensitivities)
+{
+	ThermalStack stack(1, 0.0002, 10, 0.00001, 65);
+	stack.addBlock(10, 10, parameters.zSpreader, Material(parameters.kSpreader, copper.c, "Copper"), 0);
+	stack.addInterface(parameters.interfaceResistance);
+	stack.addBlock(4, 4, parameters.zDie, Material(parameters.kDie, silicon.c, "Silicon"), 10);
+	stack.setConvectionBottom(0.04, 65);
+	stack.monitorBlock(1);
+	captureOutput([&]() { stack.mesh(); });
+
+	ImpedanceSensitivities computed;
+	captureOutput([&]() { computed = stack.computeSensitivities(); });
+	if (sensitivities != nullptr) {
+		*sensitivities = computed;
+	}
+	return computed.thermalImpedance;
+}
+
+// The adjoint derivatives must match central differences of fresh solves. Thicknesses are non-integer so that
+// the perturbed stacks keep the same element counts, as the adjoint thickness derivative assumes.
+static void testSensitivitiesMatchFiniteDifferences()
+{
+	BondedStack base = { copper.k, silicon.k, 2.5, 1.5, 20 };
+
+	ImpedanceSensitivities adjoint;
+	bondedImpedance(base, &adjoint);
+
+	double * parameters[5] = { &base.kSpreader, &base.kDie, &base.zSpreader, &base.zDie, &base.interfaceResistance };
+	double adjointValues[5] = { adjoint.dZdk[0], adjoint.dZdk[1], adjoint.dZdThickness[0], adjoint.dZdThickness[1],
+								adjoint.dZdInterface[0] };
+
+	for (int i = 0; i < 5; i++) {
+		double value = *parameters[i];
+		double step = value * 1e-3;
+
+		*parameters[i] = value + step;
+		double above = bondedImpedance(base, nullptr);
+		*parameters[i] = value - step;
+		double below = bondedImpedance(base, nullptr);
+		*parameters[i] = value;
+
+		double difference = (above - below) / (2 * step);
+		if (!isClose(adjointValues[i], difference, 1e-3)) {
+			std::cerr << "sensitivity " << i << ": adjoint " << adjointValues[i] << ", central difference " << difference << std::endl;
+			failureCount++;
+		}
+	}
+}
+
+// One element is a lumped RC, so its only mode must have tau = R C; on a real stack the listed modes must carry
+// about the whole rise, and a mesh with repeated eigenvalues must not break the iteration
+static void testTimeConstants()
+{
+	ThermalStack lumped(1, 0.0002, 10, 0.00001, 25);
+	lumped.addBlock(1, 1, 1, copper, 1);
+	lumped.setConvectionBottom(0.04, 65);
+	lumped.monitorBlock(0);
+	captureOutput([&]() { lumped.mesh(); });
+
+	double resistance = steadyImpedance(lumped);
+	ThermalModes lumpedModes;
+	captureOutput([&]() { lumpedModes = lumped.computeTimeConstants(1); });
+
+	CHECK(lumpedModes.timeConstants.size() == 1);
+	CHECK(lumpedModes.timeConstants.size() == 1 && isClose(lumpedModes.timeConstants[0], resistance * copper.c, 1e-6));
+	CHECK(lumpedModes.participation.size() == 1 && isClose(lumpedModes.participation[0], 1, 1e-6));
+
+	ThermalStack spreader(1, 0.0002, 10, 0.00001, 25);
+	buildSpreader(spreader, 65);
+	captureOutput([&]() { spreader.mesh(); });
+
+	ThermalModes spreaderModes;
+	captureOutput([&]() { spreaderModes = spreader.computeTimeConstants(10); });
+
+	double participationSum = 0;
+	for (int k = 0; k < spreaderModes.participation.size(); k++) {
+		participationSum += spreaderModes.participation[k];
+		CHECK(k == 0 || spreaderModes.timeConstants[k] <= spreaderModes.timeConstants[k - 1]);
+	}
+	CHECK(spreaderModes.unconvergedModes == 0);
+	CHECK(spreaderModes.participation.size() == 10);
+	CHECK(fabs(participationSum - 1) < 0.02);
+
+	// a symmetric slab has repeated modes, so its Krylov space runs out before all nine are found
+	ThermalStack slab(1, 0.0002, 10, 0.00001, 25);
+	slab.addBlock(3, 3, 1, copper, 1);
+	slab.setConvectionBottom(0.04, 65);
+	slab.monitorBlock(0);
+	captureOutput([&]() { slab.mesh(); });
+
+	ThermalModes slabModes;
+	captureOutput([&]() { slabModes = slab.computeTimeConstants(9); });
+
+	CHECK(slabModes.timeConstants.size() + slabModes.unconvergedModes == 9);
+	for (int k = 0; k < slabModes.timeConstants.size(); k++) {
+		CHECK(slabModes.timeConstants[k] > 0);
+	}
+}
+
+// Number following "key": in a JSON report, NaN if absent
+static double jsonNumber(const std::string & json, const std::string & key)
+{
+	std::string label = "\"" + key + "\": ";
+	size_t at = json.find(label);
+	if (at == std::string::npos) {
+		return NAN;
+	}
+	return atof(json.c_str() + at + label.size());
+}
+
+// The JSON report must describe the run that was printed, and the progress callback must fire at every sample
+// when unthrottled and not at all when its interval outlasts the run
+static void testRunReportAndProgressThrottling()
+{
+	char reportPath[] = "/tmp/ThermalStackTestsReportXXXXXX";
+	int reportFile = mkstemp(reportPath);
+	if (reportFile < 0) {
+		CHECK(!"could not create a report file");
+		return;
+	}
+	close(reportFile);
+
+	double minIntervals[2] = { 0, 1e9 };
+	long callbackCounts[2];
+	long reportedSteps[2];
+
+	for (int run = 0; run < 2; run++) {
+		ThermalStack stack(1, 0.0002, 10, 0.00001, 65);
+		buildSpreader(stack, 65);
+		stack.enableInstrumentation(reportPath);
+
+		long callbacks = 0;
+		stack.setProgressCallback([&](const SolveProgress &) { callbacks++; }, minIntervals[run]);
+
+		std::string output = captureOutput([&]() {
+			stack.mesh();
+			stack.solve();
+		});
+
+		std::ifstream reportStream(reportPath);
+		std::stringstream report;
+		report << reportStream.rdbuf();
+		std::string json = report.str();
+
+		CHECK(json.find("\"converged\": true") != std::string::npos);
+		CHECK(jsonNumber(json, "active_elements") == reportedElementCount(output));
+		CHECK(isClose(jsonNumber(json, "thermal_impedance"), reportedImpedance(output), 1e-3));
+		CHECK(jsonNumber(json, "stepping") > 0);
+
+		callbackCounts[run] = callbacks;
+		reportedSteps[run] = (long)jsonNumber(json, "steps");
+	}
+
+	remove(reportPath);
+
+	CHECK(reportedSteps[0] > 0 && reportedSteps[0] == reportedSteps[1]);
+	CHECK(callbackCounts[0] == reportedSteps[0] / 10);
+	CHECK(callbackCounts[1] == 0);
+}
+
+// An interface must conduct like a thin meshed layer of the same areal resistance under the die. The layer is
+// thin next to the mesh size, so its sideways conduction is small.
+static void testInterfaceMatchesMeshedLayer()
+{
+	double resistance = 20;
+	double layerThickness = 0.05;
+
+	ThermalStack bonded(1, 0.0002, 10, 0.00001, 65);
+	bonded.addBlock(10, 10, 2, copper, 0);
+	bonded.addInterface(resistance);
+	bonded.addBlock(4, 4, 1, silicon, 10);
+	bonded.setConvectionBottom(0.04, 65);
+	bonded.monitorBlock(1);
+	captureOutput([&]() { bonded.mesh(); });
+
+	ThermalStack layered(1, 0.0002, 10, 0.00001, 65);
+	layered.addBlock(10, 10, 2, copper, 0);
+	layered.addBlock(4, 4, layerThickness, Material(layerThickness / resistance, silicon.c, "Bond line"), 0);
+	layered.addBlock(4, 4, 1, silicon, 10);
+	layered.setConvectionBottom(0.04, 65);
+	layered.monitorBlock(2);
+	captureOutput([&]() { layered.mesh(); });
+
+	ThermalStack unbonded(1, 0.0002, 10, 0.00001, 65);
+	buildSpreader(unbonded, 65);
+	captureOutput([&]() { unbonded.mesh(); });
+
+	double bondedImpedance = steadyImpedance(bonded);
+	double layeredImpedance = steadyImpedance(layered);
+
+	CHECK(bondedImpedance > steadyImpedance(unbonded) + 0.5 * resistance / 16);
+	CHECK(isClose(bondedImpedance, layeredImpedance, 1e-4));
+}
+
+// A slow callback must still see every sample, in order, and have finished before solve() returns
+static void testProgressCallbacksOrderedAndDrained()
+{
+	ThermalStack stack(1, 0.0002, 10, 0.00001, 65);
+	buildSpreader(stack, 65);
+
+	std::vector<long> steps;
+	std::atomic<bool> solveReturned(false);
+	std::atomic<int> lateCallbacks(0);
+
+	stack.setProgressCallback([&](const SolveProgress & progress) {
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+		if (solveReturned) {
+			lateCallbacks++;
+		}
+		steps.push_back(progress.step);
+	});
+
+	std::string output = captureOutput([&]() {
+		stack.mesh();
+		stack.solve();
+		solveReturned = true;
+	});
+
+	double settledTime = 0, settledTemperature = 0;
+	CHECK(reportedMarker(output, "steady state", settledTime, settledTemperature));
+
+	CHECK(lateCallbacks == 0);
+	CHECK(!steps.empty() && steps.back() == (long)round(settledTime / 0.0002));
+	for (unsigned int i = 1; i < steps.size(); i++) {
+		CHECK(steps[i] == steps[i - 1] + 10);
+	}
+}
+
+// Thickening a solved block past an element layer re-meshes it; the warm re-solve must match a stack built that thick
+static void testThicknessEditMatchesFreshStack()
+{
+	ThermalStack edited(1, 0.0002, 10, 0.00001, 65);
+	buildSpreader(edited, 65);
+	edited.setProgressCallback(ProgressCallback());
+
+	std::string output = captureOutput([&]() {
+		edited.mesh();
+		edited.solveSteady();
+		edited.setBlockThickness(0, 3.5);
+	});
+	int editedElementCount = reportedElementCount(output);
+	double editedSteadyImpedance = steadyImpedance(edited);
+
+	edited.setBlockPower(1, 15);
+	double editedTransientImpedance = reportedImpedance(captureOutput([&]() { edited.solve(); }));
+
+	ThermalStack fresh(1, 0.0002, 10, 0.00001, 65);
+	fresh.addBlock(10, 10, 3.5, copper, 0);
+	fresh.addBlock(4, 4, 1, silicon, 10);
+	fresh.setConvectionBottom(0.04, 65);
+	fresh.monitorBlock(1);
+	int freshElementCount = reportedElementCount(captureOutput([&]() { fresh.mesh(); }));
+	double freshImpedance = steadyImpedance(fresh);
+
+	CHECK(editedElementCount == freshElementCount);
+	CHECK(freshElementCount == 10 * 10 * 4 + 4 * 4);
+	CHECK(isClose(editedSteadyImpedance, freshImpedance, 1e-6));
+	CHECK(isClose(editedTransientImpedance, freshImpedance, 0.01));
+}
+
+// Stepping refreshes k(T) conductances lazily as elements drift, so a transient must settle at the steady Z
+static void testTransientConductivityTableMatchesSteady()
+{
+	Material tabulatedSilicon({ 25, 75, 125, 175 }, { 0.148, 0.119, 0.098, 0.083 }, silicon.c, "Silicon");
+	double impedances[2];
+
+	for (int steady = 0; steady < 2; steady++) {
+		ThermalStack stack(1, 0.0002, 10, 0.00001, 65);
+		stack.addBlock(10, 10, 2, copper, 0);
+		stack.addBlock(4, 4, 1, tabulatedSilicon, 20);
+		stack.setConvectionBottom(0.04, 65);
+		stack.monitorBlock(1);
+		stack.setProgressCallback(ProgressCallback());
+
+		impedances[steady] = reportedImpedance(captureOutput([&]() {
+			stack.mesh();
+			if (steady) {
+				stack.solveSteady();
+			}
+			else {
+				stack.solve();
+			}
+		}));
+	}
+
+	ThermalStack constant(1, 0.0002, 10, 0.00001, 65);
+	buildSpreader(constant, 65);
+	constant.setBlockPower(1, 20);
+	captureOutput([&]() { constant.mesh(); });
+
+	CHECK(isClose(impedances[0], impedances[1], 0.01));
+	CHECK(impedances[0] > steadyImpedance(constant) * 1.01);
+}
+
+// Counts are summed over processes as doubles, but must still print as integers after a report has set std::fixed
+static void testMeshCountsPrintAsIntegers()
+{
+	ThermalStack stack(1, 0.0002, 10, 0.00001, 65);
+	buildSpreader(stack, 65);
+
+	std::string output = captureOutput([&]() {
+		stack.mesh();
+		stack.solveSteady();
+		stack.setBlockThickness(0, 3.5);
+	});
+
+	CHECK(output.find("Generated 416 elements\n") != std::string::npos);
+	CHECK(output.find("Created 100 boundaries\n") != std::string::npos);
+}
+
+// Meshing twice from C++ must start over cleanly and solve like a stack meshed once
+static void testMeshTwiceStartsOver()
+{
+	ThermalStack once(1, 0.0002, 10, 0.00001, 65);
+	buildSpreader(once, 65);
+	int onceElementCount = reportedElementCount(captureOutput([&]() { once.mesh(); }));
+	double onceImpedance = steadyImpedance(once);
+
+	ThermalStack twice(1, 0.0002, 10, 0.00001, 65);
+	buildSpreader(twice, 65);
+	twice.setProgressCallback(ProgressCallback());
+	captureOutput([&]() {
+		twice.mesh();
+		twice.step(100);
+	});
+	int twiceElementCount = reportedElementCount(captureOutput([&]() { twice.mesh(); }));
+
+	CHECK(twice.isMeshed());
+	CHECK(twiceElementCount == onceElementCount);
+	CHECK(twice.getTime() == 0);
+	CHECK(twice.getBlockStatistics(1).meanTemperature == 65);
+	CHECK(isClose(steadyImpedance(twice), onceImpedance, 1e-9));
+}
+
+// A traced block must take each step's power from the start of the step, so that a ramp deposits its left sum
+static void testTracePowerSampledAtStepStart()
+{
+	char tracePath[] = "/tmp/ThermalStackTestsTraceXXXXXX";
+	int traceFile = mkstemp(tracePath);
+	if (traceFile < 0) {
+		CHECK(!"could not create a trace file");
+		return;
+	}
+	close(traceFile);
+	std::ofstream(tracePath) << "0, 0\n1, 10\n";
+
+	double timeStep = 0.0002;
+	int stepCount = 1000;
+
+	ThermalStack stack(1, timeStep, 10, 0.00001, 25);
+	stack.addBlock(1, 1, 1, copper, 0);
+	stack.monitorBlock(0);
+	captureOutput([&]() {
+		stack.mesh();
+		stack.setBlockPowerTrace(0, tracePath);
+		stack.step(stepCount);
+	});
+
+	remove(tracePath);
+
+	// sum of 10 W/s * (k timeStep) * timeStep over k = 0 to stepCount - 1
+	double energy = 10 * timeStep * timeStep * stepCount * (stepCount - 1) / 2;
+	CHECK(isClose(stack.getBlockStatistics(0).meanTemperature - 25, energy / copper.c, 1e-9));
+}
+
+int main()
+{
+	testSteadyImpedanceIgnoresStartingTemperature();
+	testTransientImpedanceFromAmbient();
+	testMeshStudyMatchesDirectSolve();
+	testCacheKeyCoversGeometry();
+	testTransientCacheNeedsColdStart();
+	testTraceEditedInPlaceMissesCache();
+	testPowerTraceAttachedAfterMesh();
+	testDecompositionNeedsALayerPerProcess();
+	testCApiMeshesOnce();
+	testCApiTimeIsElapsedTime();
+	testOverlapKeepsFirstBlockAndConservesPower();
+	testConductivityTableEditsAfterMesh();
+	testMeshStudyChecksMonitoredBlockAndTolerance();
+	testSensitivitiesMatchFiniteDifferences();
+	testTimeConstants();
+	testRunReportAndProgressThrottling();
+	testInterfaceMatchesMeshedLayer();
+	testProgressCallbacksOrderedAndDrained();
+	testThicknessEditMatchesFreshStack();
+	testTransientConductivityTableMatchesSteady();
+	testMeshCountsPrintAsIntegers();
+	testMeshTwiceStartsOver();
+	testTracePowerSampledAtStepStart();
+
+	if (failureCount > 0) {
+		std::cerr << failureCount << " check(s) failed" << std::endl;
+		return 1;
+	}
+
+	std::cout << "All checks passed" << std::endl;
+	return 0;
+}